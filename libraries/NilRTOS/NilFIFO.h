@@ -28,6 +28,73 @@
 #ifndef NilFIFO_h
 #define NilFIFO_h
 #include <NilRTOS.h>
+#if NIL_CFG_FIFO_LATENCY || defined(__DOXYGEN__)
+/** Latency histogram bins, one for each bit of a 16-bit time stamp. */
+const uint8_t NIL_FIFO_LATENCY_BINS = 17;
+#endif  // NIL_CFG_FIFO_LATENCY
+//------------------------------------------------------------------------------
+/** Index type for a FIFO with more than 256 records. */
+template<bool Small> struct NilFifoIndexType {typedef size_t type;};
+/** Index type for a FIFO with at most 256 records. */
+template<> struct NilFifoIndexType<true> {typedef uint8_t type;};
+/**
+ * @class NilFifoIndex
+ * \brief FIFO index arithmetic selected at compile time.
+ *
+ * Indices use the narrowest type that holds Size - 1.  If Size is a
+ * power of two an index wraps with a mask, else with a compare.
+ */
+template<size_t Size>
+struct NilFifoIndex {
+  /** Index type. */
+  typedef typename NilFifoIndexType<(Size <= 256)>::type type;
+  /** @return true if Size is a power of two. */
+  static bool pow2() {return (Size & (Size - 1)) == 0;}
+  /**
+   * Advance an index.
+   * @param[in] i  the index.
+   * @param[in] n  the count, at most Size - i.
+   * @return the index n records after i.
+   */
+  static type advance(type i, size_t n) {
+    if (pow2()) return (i + n) & (Size - 1);
+    return i + n < Size ? i + n : 0;
+  }
+};
+//------------------------------------------------------------------------------
+/**
+ * Take up to n counts from a semaphore without waiting.
+ *
+ * @param[in] sp  the semaphore.
+ * @param[in] n   the maximum count to take.
+ *
+ * @return the count taken.
+ */
+inline size_t nilFifoTake(semaphore_t* sp, size_t n) {
+  if (n == 0) return 0;
+  nilSysLock();
+  cnt_t cnt = sp->cnt;
+  if (cnt <= 0) {
+    n = 0;
+  } else if ((size_t)cnt < n) {
+    n = cnt;
+  }
+  sp->cnt -= n;
+  nilSysUnlock();
+  return n;
+}
+/**
+ * Signal a semaphore n times with one reschedule.
+ *
+ * @param[in] sp  the semaphore.
+ * @param[in] n   the signal count.
+ */
+inline void nilFifoSignal(semaphore_t* sp, size_t n) {
+  nilSysLock();
+  while (n--) nilSemSignalI(sp);
+  nilSchRescheduleS();
+  nilSysUnlock();
+}
 //------------------------------------------------------------------------------
  /**
   * @class NilStatsFIFO
@@ -35,6 +102,9 @@
   *
   * A FIFO for a single producer/consumer pair with statistics.
   *
+  * If NIL_CFG_FIFO_LATENCY is TRUE, records are time stamped by
+  * signalData() and the time to waitData() is kept in a log2 histogram.
+  * Each record uses three more bytes of RAM.
   */
 template<typename Type, size_t Size>
 class NilStatsFIFO {
@@ -44,6 +114,12 @@ class NilStatsFIFO {
     _minFree(Size), _overrun(0), _tail(0) {
     nilSemInit(&_dataSem, 0);
     nilSemInit(&_freeSem, Size);
+#if NIL_CFG_FIFO_LATENCY
+    _stampHead = 0;
+    _latMin = 0XFFFF;
+    _latMax = 0;
+    for (uint8_t i = 0; i < NIL_FIFO_LATENCY_BINS; i++) _latHist[i] = 0;
+#endif  // NIL_CFG_FIFO_LATENCY
   }
   /** Increment overrun count
    * @note Must only be called in producer thread.
@@ -80,12 +156,43 @@ class NilStatsFIFO {
     nilSysUnlock();
     return rtn;
   }
+#if NIL_CFG_FIFO_LATENCY || defined(__DOXYGEN__)
+  /**
+   * Latency percentile.
+   *
+   * @param[in] pct percent of records, 1 to 100.
+   *
+   * @note Must be called when the consumer is idle.
+   * @return usec within which pct percent of records were taken by the
+   *         consumer, rounded up to a histogram bin.  Zero if no record
+   *         was taken.
+   */
+  uint32_t latencyPercentile(uint8_t pct) {
+    uint32_t total = 0;
+    uint8_t i;
+    for (i = 0; i < NIL_FIFO_LATENCY_BINS; i++) total += _latHist[i];
+    if (total == 0) return 0;
+    // Rank of the record, rounded up.
+    uint32_t rank = (total/100)*pct + ((total%100)*pct + 99)/100;
+    uint32_t sum = 0;
+    for (i = 0; i < NIL_FIFO_LATENCY_BINS - 1; i++) {
+      sum += _latHist[i];
+      if (sum >= rank) break;
+    }
+    // Upper bound of bin i, at most the maximum.
+    uint16_t t = i < 16 ? (1UL << i) - 1 : 0XFFFF;
+    return HR2US(t < _latMax ? t : _latMax);
+  }
+#endif  // NIL_CFG_FIFO_LATENCY
 
   /**
    * Print FIFO statistics.
    *
    * @param[in] pr Print stream for the output.
    *
+   * @note Latency is measured in 16-bit time stamp units, about 262 msec
+   *       on a 16 MHz Arduino.  Longer waits are counted as the maximum
+   *       in the top bin so the max and p99 are lower bounds.
    * @note Must be called when consumer/producer are idle
    *       for consistent results.
    */
@@ -100,6 +207,31 @@ class NilStatsFIFO {
       pr->print(F("Maximum overrun count: "));
       pr->println(_maxOverrun);
     }
+#if NIL_CFG_FIFO_LATENCY
+    // No record was taken.
+    if (_latMin > _latMax) return;
+    pr->print(F("Latency usec min,max: "));
+    pr->print(HR2US(_latMin));
+    pr->print(',');
+    pr->print(HR2US(_latMax));
+    // Saturated, a record waited at least this long.
+    if (_latMax == 0XFFFF) pr->print(F(" or more"));
+    pr->println();
+    pr->print(F("Latency usec p50,p90,p99: "));
+    pr->print(latencyPercentile(50));
+    pr->print(',');
+    pr->print(latencyPercentile(90));
+    pr->print(',');
+    pr->println(latencyPercentile(99));
+    pr->println(F("Latency usec,count"));
+    uint8_t last = NIL_FIFO_LATENCY_BINS - 1;
+    while (last && _latHist[last] == 0) last--;
+    for (uint8_t i = 0; i <= last; i++) {
+      pr->print(i ? HR2US(1UL << (i - 1)) : 0);
+      pr->print(',');
+      pr->println(_latHist[i]);
+    }
+#endif  // NIL_CFG_FIFO_LATENCY
   }
   
   /** Signal that a data record is ready.
@@ -107,16 +239,33 @@ class NilStatsFIFO {
    */
   void signalData() {
     _overrun = 0;
+    stamp(1);
     nilSemSignal(&_dataSem);
   }
+  /** Signal that data records are ready.
+   * @param[in] n count of records, the count from waitFreeSpan().
+   * @note Must only be called in producer thread.
+   */
+  void signalData(size_t n) {
+    _overrun = 0;
+    stamp(n);
+    nilFifoSignal(&_dataSem, n);
+  }
   /** Signal that a record is free.
    * @note Must only be called in consumer thread.
    */
   void signalFree() {
-    cnt_t cnt = freeCount();
-    if (cnt < _minFree) _minFree = cnt;
+    updateMinFree();
     nilSemSignal(&_freeSem);
   }
+  /** Signal that records are free.
+   * @param[in] n count of records, the count from waitDataSpan().
+   * @note Must only be called in consumer thread.
+   */
+  void signalFree(size_t n) {
+    updateMinFree();
+    nilFifoSignal(&_freeSem, n);
+  }
   
   /**
    * Wait for a data record.
@@ -133,7 +282,46 @@ class NilStatsFIFO {
       return 0;
     }
     Type* rtn = &_data[_tail];
-    _tail = _tail < (Size - 1) ? _tail + 1 : 0;
+    latency(1);
+    _tail = Index::advance(_tail, 1);
+    return rtn;
+  }
+
+  /**
+   * Wait for a span of contiguous data records.
+   *
+   * Waits for one record then takes up to maxCount records that are
+   * ready, stopping at the end of the buffer.
+   *
+   * @param[in] maxCount  the maximum number of records.  Zero returns
+   *                      null without waiting.
+   * @param[in] time      the number of ticks before the operation timeouts,
+   *                      the following special values are allowed:
+   *                      - @a TIME_IMMEDIATE immediate timeout.
+   *                      - @a TIME_INFINITE no timeout.
+   *                      .
+   * @param[out] count    the number of records in the span.
+   * @note Must only be called in consumer thread.  Free the span with
+   *       signalFree(count).
+   * @return pointer to the first data record or null if no data record
+   *         is available.
+   */
+  Type* waitDataSpan(size_t maxCount, systime_t time, size_t* count) {
+    if (maxCount == 0) {
+      *count = 0;
+      return 0;
+    }
+    if (nilSemWaitTimeout(&_dataSem, time) != NIL_MSG_OK) {
+      *count = 0;
+      return 0;
+    }
+    size_t n = Size - _tail;
+    if (n > maxCount) n = maxCount;
+    n = 1 + nilFifoTake(&_dataSem, n - 1);
+    Type* rtn = &_data[_tail];
+    latency(n);
+    _tail = Index::advance(_tail, n);
+    *count = n;
     return rtn;
   }
   
@@ -153,7 +341,45 @@ class NilStatsFIFO {
       return 0;
     }
     Type* rtn = &_data[_head];
-    _head = _head < (Size - 1) ? _head + 1 : 0;
+    _head = Index::advance(_head, 1);
+    return rtn;
+  }
+
+  /**
+   * Wait for a span of contiguous free records.
+   *
+   * Waits for one record then takes up to maxCount records that are
+   * free, stopping at the end of the buffer.
+   *
+   * @param[in] maxCount  the maximum number of records.  Zero returns
+   *                      null without waiting.
+   * @param[in] time      the number of ticks before the operation timeouts,
+   *                      the following special values are allowed:
+   *                      - @a TIME_IMMEDIATE immediate timeout.
+   *                      - @a TIME_INFINITE no timeout.
+   *                      .
+   * @param[out] count    the number of records in the span.
+   * @note Must only be called in producer thread.  Send the span with
+   *       signalData(count).
+   * @return pointer to the first free record or null if no free record
+   *         is available.
+   */
+  Type* waitFreeSpan(size_t maxCount, systime_t time, size_t* count) {
+    if (maxCount == 0) {
+      *count = 0;
+      return 0;
+    }
+    if (nilSemWaitTimeout(&_freeSem, time) != NIL_MSG_OK) {
+      countOverrun();
+      *count = 0;
+      return 0;
+    }
+    size_t n = Size - _head;
+    if (n > maxCount) n = maxCount;
+    n = 1 + nilFifoTake(&_freeSem, n - 1);
+    Type* rtn = &_data[_head];
+    _head = Index::advance(_head, n);
+    *count = n;
     return rtn;
   }
 
@@ -161,11 +387,59 @@ class NilStatsFIFO {
   Type _data[Size];
   semaphore_t _dataSem;
   semaphore_t _freeSem;
-  size_t _head;
+  typedef NilFifoIndex<Size> Index;
+#if NIL_CFG_FIFO_LATENCY
+  // Time stamp n records signaled by the producer.
+  void stamp(size_t n) {
+    uint32_t t = nilTimeNowHiRes();
+    while (n--) {
+      _stamp[_stampHead] = t;
+      _stampHigh[_stampHead] = t >> 16;
+      _stampHead = Index::advance(_stampHead, 1);
+    }
+  }
+  // Record latency of n records at the tail.
+  void latency(size_t n) {
+    uint32_t t = nilTimeNowHiRes();
+    typename Index::type k = _tail;
+    while (n--) {
+      // The high byte of the stamp detects a wait longer than the
+      // 16-bit range, the wait is saturated to the top bin.
+      uint32_t e = (t - ((uint32_t)_stampHigh[k] << 16 | _stamp[k]))
+                   & 0XFFFFFFUL;
+      uint16_t d = e > 0XFFFF ? 0XFFFF : e;
+      k = Index::advance(k, 1);
+      if (d < _latMin) _latMin = d;
+      if (d > _latMax) _latMax = d;
+      uint8_t i = 0;
+      while (d) {
+        d >>= 1;
+        i++;
+      }
+      if (_latHist[i] != (uint32_t)-1) _latHist[i]++;
+    }
+  }
+  uint32_t _latHist[NIL_FIFO_LATENCY_BINS];
+  uint16_t _latMax;
+  uint16_t _latMin;
+  uint16_t _stamp[Size];
+  uint8_t _stampHigh[Size];
+  typename Index::type _stampHead;
+#else  // NIL_CFG_FIFO_LATENCY
+  void stamp(size_t) {}
+  void latency(size_t) {}
+#endif  // NIL_CFG_FIFO_LATENCY
+  // A negative count is a producer waiting on a full FIFO.
+  void updateMinFree() {
+    cnt_t cnt = nilSemGetCounter(&_freeSem);
+    size_t n = cnt < 0 ? 0 : cnt;
+    if (n < _minFree) _minFree = n;
+  }
+  typename Index::type _head;
   size_t _maxOverrun;
   size_t _minFree;
   size_t _overrun;
-  size_t _tail;
+  typename Index::type _tail;
 };
 //------------------------------------------------------------------------------
  /**
@@ -195,12 +469,26 @@ class NilFIFO {
   void signalData() {
     nilSemSignal(&_dataSem);
   }
+  /** Signal that data records are ready.
+   * @param[in] n count of records, the count from waitFreeSpan().
+   * @note Must only be called in producer thread.
+   */
+  void signalData(size_t n) {
+    nilFifoSignal(&_dataSem, n);
+  }
   /** Signal that a record is free.
    * @note Must only be called in consumer thread.
    */
   void signalFree() {
     nilSemSignal(&_freeSem);
   }
+  /** Signal that records are free.
+   * @param[in] n count of records, the count from waitDataSpan().
+   * @note Must only be called in consumer thread.
+   */
+  void signalFree(size_t n) {
+    nilFifoSignal(&_freeSem, n);
+  }
 
   /**
    * Wait for a data record.
@@ -217,7 +505,44 @@ class NilFIFO {
       return 0;
     }
     Type* rtn = &_data[_tail];
-    _tail = _tail < (Size - 1) ? _tail + 1 : 0;
+    _tail = Index::advance(_tail, 1);
+    return rtn;
+  }
+
+  /**
+   * Wait for a span of contiguous data records.
+   *
+   * Waits for one record then takes up to maxCount records that are
+   * ready, stopping at the end of the buffer.
+   *
+   * @param[in] maxCount  the maximum number of records.  Zero returns
+   *                      null without waiting.
+   * @param[in] time      the number of ticks before the operation timeouts,
+   *                      the following special values are allowed:
+   *                      - @a TIME_IMMEDIATE immediate timeout.
+   *                      - @a TIME_INFINITE no timeout.
+   *                      .
+   * @param[out] count    the number of records in the span.
+   * @note Must only be called in consumer thread.  Free the span with
+   *       signalFree(count).
+   * @return pointer to the first data record or null if no data record
+   *         is available.
+   */
+  Type* waitDataSpan(size_t maxCount, systime_t time, size_t* count) {
+    if (maxCount == 0) {
+      *count = 0;
+      return 0;
+    }
+    if (nilSemWaitTimeout(&_dataSem, time) != NIL_MSG_OK) {
+      *count = 0;
+      return 0;
+    }
+    size_t n = Size - _tail;
+    if (n > maxCount) n = maxCount;
+    n = 1 + nilFifoTake(&_dataSem, n - 1);
+    Type* rtn = &_data[_tail];
+    _tail = Index::advance(_tail, n);
+    *count = n;
     return rtn;
   }
 
@@ -236,16 +561,320 @@ class NilFIFO {
       return 0;
     }
     Type* rtn = &_data[_head];
-    _head = _head < (Size - 1) ? _head + 1 : 0;
+    _head = Index::advance(_head, 1);
+    return rtn;
+  }
+
+  /**
+   * Wait for a span of contiguous free records.
+   *
+   * Waits for one record then takes up to maxCount records that are
+   * free, stopping at the end of the buffer.
+   *
+   * @param[in] maxCount  the maximum number of records.  Zero returns
+   *                      null without waiting.
+   * @param[in] time      the number of ticks before the operation timeouts,
+   *                      the following special values are allowed:
+   *                      - @a TIME_IMMEDIATE immediate timeout.
+   *                      - @a TIME_INFINITE no timeout.
+   *                      .
+   * @param[out] count    the number of records in the span.
+   * @note Must only be called in producer thread.  Send the span with
+   *       signalData(count).
+   * @return pointer to the first free record or null if no free record
+   *         is available.
+   */
+  Type* waitFreeSpan(size_t maxCount, systime_t time, size_t* count) {
+    if (maxCount == 0) {
+      *count = 0;
+      return 0;
+    }
+    if (nilSemWaitTimeout(&_freeSem, time) != NIL_MSG_OK) {
+      *count = 0;
+      return 0;
+    }
+    size_t n = Size - _head;
+    if (n > maxCount) n = maxCount;
+    n = 1 + nilFifoTake(&_freeSem, n - 1);
+    Type* rtn = &_data[_head];
+    _head = Index::advance(_head, n);
+    *count = n;
+    return rtn;
+  }
+
+ private:
+  Type _data[Size];
+  semaphore_t _dataSem;
+  semaphore_t _freeSem;
+  typedef NilFifoIndex<Size> Index;
+  typename Index::type _head;
+  typename Index::type _tail;
+};
+//------------------------------------------------------------------------------
+ /**
+  * @class NilMpmcFIFO
+  * \brief A thread safe FIFO for several producers and consumers.
+  *
+  * Each thread claims a record with a short kernel lock, then writes or
+  * reads it without the lock.  Records are committed in FIFO order, so
+  * a record written out of order waits for the records claimed before
+  * it.  Waiting threads are woken in priority order.
+  *
+  * Unlike NilFIFO, signalData() and signalFree() take the record from
+  * waitFree() and waitData().
+  */
+template<typename Type, size_t Size>
+class NilMpmcFIFO {
+ public:
+  /** constructor */
+  NilMpmcFIFO() : _commitHead(0), _commitTail(0), _head(0),
+    _reading(0), _tail(0), _writing(0) {
+    nilSemInit(&_dataSem, 0);
+    nilSemInit(&_freeSem, Size);
+    for (size_t i = 0; i < Size; i++) _done[i] = false;
+  }
+  /** @return count of data records in the FIFO. */
+  size_t dataCount() {return nilSemGetCounter(&_dataSem);}
+
+  /** @return count of free records in the FIFO. */
+  size_t freeCount() {return nilSemGetCounter(&_freeSem);}
+
+  /** Signal that a data record is ready.
+   * @param[in] p the record from waitFree().
+   */
+  void signalData(Type* p) {
+    nilSysLock();
+    _done[p - _data] = true;
+    while (_writing && _done[_commitHead]) {
+      _writing--;
+      _done[_commitHead] = false;
+      _commitHead = Index::advance(_commitHead, 1);
+      nilSemSignalI(&_dataSem);
+    }
+    nilSchRescheduleS();
+    nilSysUnlock();
+  }
+  /** Signal that a record is free.
+   * @param[in] p the record from waitData().
+   */
+  void signalFree(Type* p) {
+    nilSysLock();
+    _done[p - _data] = true;
+    while (_reading && _done[_commitTail]) {
+      _reading--;
+      _done[_commitTail] = false;
+      _commitTail = Index::advance(_commitTail, 1);
+      nilSemSignalI(&_freeSem);
+    }
+    nilSchRescheduleS();
+    nilSysUnlock();
+  }
+
+  /**
+   * Wait for a data record.
+   * @param[in] time      the number of ticks before the operation timeouts,
+   *                      the following special values are allowed:
+   *                      - @a TIME_IMMEDIATE immediate timeout.
+   *                      - @a TIME_INFINITE no timeout.
+   *                      .
+   * @return pointer to the data record or null if no data record is availabile.
+   */
+  Type* waitData(systime_t time) {
+    if (nilSemWaitTimeout(&_dataSem, time) != NIL_MSG_OK) {
+      return 0;
+    }
+    nilSysLock();
+    Type* rtn = &_data[_tail];
+    _tail = Index::advance(_tail, 1);
+    _reading++;
+    nilSysUnlock();
+    return rtn;
+  }
+
+  /**
+   * Wait for a free record.
+   * @param[in] time      the number of ticks before the operation timeouts,
+   *                      the following special values are allowed:
+   *                      - @a TIME_IMMEDIATE immediate timeout.
+   *                      - @a TIME_INFINITE no timeout.
+   *                      .
+   * @return pointer to the free record or null if no free record is availabile.
+   */
+  Type* waitFree(systime_t time) {
+    if (nilSemWaitTimeout(&_freeSem, time) != NIL_MSG_OK) {
+      return 0;
+    }
+    nilSysLock();
+    Type* rtn = &_data[_head];
+    _head = Index::advance(_head, 1);
+    _writing++;
+    nilSysUnlock();
     return rtn;
   }
 
  private:
+  typedef NilFifoIndex<Size> Index;
+  // Count of claimed records, zero to Size.
+  typedef typename NilFifoIndexType<(Size < 256)>::type Count;
   Type _data[Size];
+  // Record written or read, not yet committed.
+  bool _done[Size];
   semaphore_t _dataSem;
   semaphore_t _freeSem;
-  size_t _head;
-  size_t _tail;
+  typename Index::type _commitHead;
+  typename Index::type _commitTail;
+  typename Index::type _head;
+  // Records claimed by consumers from _commitTail.
+  Count _reading;
+  typename Index::type _tail;
+  // Records claimed by producers from _commitHead.
+  Count _writing;
+};
+//------------------------------------------------------------------------------
+ /**
+  * @class NilSpscRing
+  * \brief A lock-free ring for an ISR producer.
+  *
+  * A ring for a single producer/consumer pair with byte indices, so the
+  * producer and consumer each write one index atomically.  Adding a
+  * record only locks the kernel to check for a blocked consumer and
+  * makes no kernel calls unless the count it waits for is reached.
+  * Size must be less than 255.
+  *
+  * Example:
+  * @code
+  * NilSpscRing<uint16_t, 64> ring;
+  * NIL_IRQ_HANDLER(ADC_vect) {
+  *   NIL_IRQ_PROLOGUE();
+  *   uint16_t sample = ADC;
+  *   nilSysLockFromISR();
+  *   ring.putI(sample);
+  *   nilSysUnlockFromISR();
+  *   NIL_IRQ_EPILOGUE();
+  * }
+  * @endcode
+  */
+template<typename Type, uint8_t Size>
+class NilSpscRing {
+ public:
+  /** constructor */
+  NilSpscRing() : _count(1), _head(0), _overrun(0), _tail(0), _waiter(0) {}
+
+  /** @return count of data records in the ring. */
+  uint8_t dataCount() {
+    uint8_t h = _head;
+    uint8_t t = _tail;
+    return h >= t ? h - t : h + Size + 1 - t;
+  }
+
+  /** @return count of free records in the ring. */
+  uint8_t freeCount() {return Size - dataCount();}
+
+  /**
+   * Remove a data record.
+   * @param[out] data Location for the record.
+   * @note Must only be called in consumer thread.
+   * @return true for success or false if the ring is empty.
+   */
+  bool get(Type* data) {
+    uint8_t t = _tail;
+    if (t == _head) return false;
+    *data = _data[t];
+    barrier();
+    _tail = t < Size ? t + 1 : 0;
+    return true;
+  }
+
+  /** @return count of records dropped because the ring was full. */
+  uint16_t overrunCount() {
+    nilSysLock();
+    uint16_t rtn = _overrun;
+    nilSysUnlock();
+    return rtn;
+  }
+
+  /**
+   * Add a data record from a producer thread.
+   * @param[in] data The record.
+   * @note Must only be called in producer thread.
+   * @return true for success or false if the ring is full.
+   */
+  bool put(const Type& data) {
+    if (!putData(data)) return false;
+    nilSysLock();
+    if (resumeI()) nilSchRescheduleS();
+    nilSysUnlock();
+    return true;
+  }
+
+  /**
+   * Add a data record from an ISR.
+   * @param[in] data The record.
+   * @note Must only be called in the producer ISR.
+   * @return true for success or false if the ring is full.
+   * @iclass
+   */
+  bool putI(const Type& data) {
+    if (!putData(data)) return false;
+    resumeI();
+    return true;
+  }
+
+  /**
+   * Wait for data records.
+   * @param[in] count     the number of records, from one to Size.  The
+   *                      producer wakes the consumer when the ring has
+   *                      this many records, not for each record.
+   * @param[in] time      the number of ticks before the operation timeouts,
+   *                      the following special values are allowed:
+   *                      - @a TIME_IMMEDIATE immediate timeout.
+   *                      - @a TIME_INFINITE no timeout.
+   *                      .
+   * @note Must only be called in consumer thread.
+   * @return true if count records are available else false.
+   */
+  bool waitData(uint8_t count, systime_t time) {
+    nilSysLock();
+    if (dataCount() < count && time != TIME_IMMEDIATE) {
+      _count = count;
+      nilThdSuspendTimeoutS(&_waiter, time);
+    }
+    bool rtn = dataCount() >= count;
+    nilSysUnlock();
+    return rtn;
+  }
+
+ private:
+  // Size + 1 entries so a full ring has head != tail.
+  NIL_STATIC_ASSERT(Size < 255, ring_size_too_large);
+  /** Keep data accesses on the right side of index updates. */
+  static void barrier() {asm volatile ("" : : : "memory");}
+
+  bool putData(const Type& data) {
+    uint8_t h = _head;
+    uint8_t next = h < Size ? h + 1 : 0;
+    if (next == _tail) {
+      if (_overrun != (uint16_t)-1) _overrun++;
+      return false;
+    }
+    _data[h] = data;
+    barrier();
+    _head = next;
+    return true;
+  }
+  // The waiter is only read and written with the kernel locked.
+  bool resumeI() {
+    if (!_waiter || dataCount() < _count) return false;
+    nilThdResumeI(&_waiter, NIL_MSG_OK);
+    return true;
+  }
+
+  Type _data[Size + 1];
+  uint8_t _count;
+  volatile uint8_t _head;
+  uint16_t _overrun;
+  volatile uint8_t _tail;
+  thread_ref_t _waiter;
 };
 #endif  // NilFIFO_h
 /** @} */
\ No newline at end of file
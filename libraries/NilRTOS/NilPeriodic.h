@@ -0,0 +1,179 @@
+/* Arduino NilRTOS Library
+ * Copyright (C) 2013 by William Greiman
+ *
+ * This file is part of the Arduino NilRTOS Library
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the Arduino NilRTOS Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+ /**
+ * @file    NilPeriodic.h
+ * @brief   Nil RTOS periodic thread helper
+ *
+ * @defgroup periodic NilPeriodic
+ * @details Drift-free periodic release with deadline miss statistics.
+ * @{
+ */
+#ifndef NilPeriodic_h
+#define NilPeriodic_h
+#include <NilRTOS.h>
+//------------------------------------------------------------------------------
+/** Late releases are run at once so no release is lost. */
+const uint8_t NIL_PERIODIC_CATCH_UP = 0;
+/** Late releases are dropped, the thread waits for the next release. */
+const uint8_t NIL_PERIODIC_SKIP = 1;
+//------------------------------------------------------------------------------
+ /**
+  * @class NilPeriodic
+  * \brief Periodic release of a thread.
+  *
+  * Release times are kept as absolute system times, period after period,
+  * so time spent in the thread does not add drift.  The deadline of each
+  * release is the next release.
+  *
+  * Example:
+  * @code
+  * NilPeriodic periodic;
+  * NIL_THREAD(Sampler, arg) {
+  *   periodic.begin(MS2ST(10));
+  *   while (TRUE) {
+  *     periodic.waitNextPeriod();
+  *     // sample
+  *   }
+  * }
+  * @endcode
+  */
+class NilPeriodic {
+ public:
+  /** constructor */
+  NilPeriodic() : _maxLateness(0), _missCount(0),
+    _period(0), _policy(NIL_PERIODIC_CATCH_UP), _release(0), _skipCount(0) {}
+
+  /**
+   * Start periodic release, the first release is now.
+   *
+   * @param[in] period  the period in system ticks, less than half the
+   *                    range of systime_t.
+   * @param[in] policy  NIL_PERIODIC_CATCH_UP or NIL_PERIODIC_SKIP.
+   *
+   * @note Must only be called in the periodic thread.
+   */
+  void begin(systime_t period, uint8_t policy = NIL_PERIODIC_CATCH_UP) {
+    nilSysLock();
+    _period = period;
+    _policy = policy;
+    _release = nilTimeNowI();
+    _maxLateness = 0;
+    _missCount = 0;
+    _skipCount = 0;
+    nilSysUnlock();
+  }
+
+  /**
+   * Wait for the next release.
+   *
+   * If the next release has passed the deadline of the current release
+   * was missed.  With NIL_PERIODIC_CATCH_UP the call returns at once and
+   * later calls return at once until the thread has caught up.  With
+   * NIL_PERIODIC_SKIP missed releases are dropped and the thread sleeps
+   * until the first release in the future.
+   *
+   * @note Must only be called in the periodic thread.
+   * @return true if the deadline was met else false.
+   */
+  bool waitNextPeriod() {
+    bool rtn = true;
+    nilSysLock();
+    _release += _period;
+    systime_t ahead = _release - nilTimeNowI();
+    if (ahead > _period) {
+      // The release has passed, ahead has wrapped.
+      systime_t late = -ahead;
+      rtn = false;
+      if (_missCount != (uint32_t)-1) _missCount++;
+      if (late > _maxLateness) _maxLateness = late;
+      if (_policy == NIL_PERIODIC_CATCH_UP) {
+        nilSysUnlock();
+        return rtn;
+      }
+      systime_t n = late/_period + 1;
+      _skipCount += n;
+      _release += n*_period;
+      ahead = _release - nilTimeNowI();
+    }
+    // Zero is TIME_INFINITE.
+    if (ahead) nilThdSleepS(ahead);
+    nilSysUnlock();
+    return rtn;
+  }
+
+  /** @return maximum lateness in ticks, the time a missed deadline
+   *          was passed when waitNextPeriod() was called.
+   */
+  systime_t maxLateness() {
+    nilSysLock();
+    systime_t rtn = _maxLateness;
+    nilSysUnlock();
+    return rtn;
+  }
+
+  /** @return count of missed deadlines. */
+  uint32_t missCount() {
+    nilSysLock();
+    uint32_t rtn = _missCount;
+    nilSysUnlock();
+    return rtn;
+  }
+
+  /** @return period in ticks. */
+  systime_t period() {return _period;}
+
+  /** @return count of releases dropped by NIL_PERIODIC_SKIP. */
+  uint32_t skipCount() {
+    nilSysLock();
+    uint32_t rtn = _skipCount;
+    nilSysUnlock();
+    return rtn;
+  }
+
+  /**
+   * Print periodic release statistics.
+   *
+   * @param[in] pr Print stream for the output.
+   */
+  void printStats(Print* pr) {
+    pr->print(F("Period ticks: "));
+    pr->println(_period);
+    pr->print(F("Deadline misses: "));
+    pr->println(missCount());
+    if (_missCount) {
+      pr->print(F("Maximum lateness ticks: "));
+      pr->println(maxLateness());
+      if (_policy == NIL_PERIODIC_SKIP) {
+        pr->print(F("Skipped releases: "));
+        pr->println(skipCount());
+      }
+    }
+  }
+
+ private:
+  systime_t _maxLateness;
+  uint32_t _missCount;
+  systime_t _period;
+  uint8_t _policy;
+  systime_t _release;
+  uint32_t _skipCount;
+};
+#endif  // NilPeriodic_h
+/** @} */
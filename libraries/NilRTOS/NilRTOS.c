@@ -28,6 +28,12 @@
 
 #include <NilRTOS.h>
 #include <avr_heap.h>
+/** Time reserved for the wakeup when nilThdDelayMicroseconds() sleeps. */
+#ifndef NIL_DELAY_WAKEUP_USEC
+#define NIL_DELAY_WAKEUP_USEC 50
+#endif  // NIL_DELAY_WAKEUP_USEC
+/** nilTimeNowHiRes() counts per system tick. */
+#define HR_PER_TICK (F_CPU / NIL_CFG_FREQUENCY / PORT_TIME_STAMP_CYCLES)
 //------------------------------------------------------------------------------
 static __attribute__((noinline)) void fill8(uint8_t* bgn, uint8_t* end) {
   while (bgn < end) *bgn++ = 0X55;
@@ -55,7 +61,8 @@ cnt_t nilSemGetCounter(semaphore_t *sp) {
  */
 size_t nilUnusedStack(uint8_t nt) {
   thread_config_t *tcp = &nil_thd_configs[nt];
-  return fillSize(tcp->wap, tcp->wap + tcp->size);
+  // Skip the stack guard.
+  return fillSize(tcp->wap + NIL_STACK_GUARD_SIZE, tcp->wap + tcp->size);
 }
 //------------------------------------------------------------------------------
 /**
@@ -81,7 +88,7 @@ static void nilFillStacks() {
 //------------------------------------------------------------------------------
 /** Start Nil RTOS with all stack memory initialized to a known value.
  *
- * @return TRUE for success else FALSE.
+ * @return TRUE, thread table errors are compile errors.
  */
 bool nilSysBegin() {
   nilFillStacks();
@@ -91,10 +98,10 @@ bool nilSysBegin() {
 /** Start Nil RTOS with raw uninitialized stack memory.
  *  This call saves a little flash compared to nilSysBegin().
  *
- * @return TRUE for success else FALSE.
+ * @return TRUE, thread table errors are compile errors.
  */
 bool nilSysBeginNoFill() {
-  if (!nil_thd_count) return FALSE;
+  // The thread count is checked at compile time by NIL_THREADS_TABLE_END().
   nilSysLock();
   boardInit();
   nilSysInit();
@@ -108,7 +115,8 @@ bool nilSysBeginNoFill() {
  *
  * @note    This function does not sleep and will block all lower
  *          priority threads.  This function should only be used
- *          in the idle thread.
+ *          in the idle thread or to simulate CPU use, see
+ *          @p nilThdDelayMicroseconds().
  * @api
  */
 void nilThdDelay(systime_t time) {
@@ -132,6 +140,40 @@ void nilThdDelayUntil(systime_t time) {
   nilThdDelay(time - nilTimeNow());
 }
 //------------------------------------------------------------------------------
+/**
+ * @brief   Delay the invoking thread for the specified time with
+ *          @p nilTimeNowHiRes() precision.
+ * @details A thread sleeps for the whole ticks of the delay, so lower
+ *          priority threads run, and then spins on @p nilTimeNowHiRes()
+ *          for the rest.  The idle thread, which must not sleep, spins
+ *          for the whole delay.
+ * @note    The delay ends within a few microseconds of the specified
+ *          time unless the thread is preempted while it spins.
+ *
+ * @param[in] usec      the delay in microseconds, less than half the range
+ *                      of systime_t ticks.
+ *
+ * @api
+ */
+void nilThdDelayMicroseconds(uint32_t usec) {
+  uint32_t end = nilTimeNowHiRes() + US2HR(usec);
+
+  if (!nilIsIdleThread()) {
+    // Last tick that leaves time for the wakeup before the end.
+    systime_t wake = (end - US2HR(NIL_DELAY_WAKEUP_USEC))/HR_PER_TICK;
+    nilSysLock();
+    systime_t ahead = wake - nilTimeNowI();
+    // A tick in the past wraps to more than half the range.  Zero is
+    // TIME_INFINITE and tick-less timeouts below TIMEDELTA are rounded up.
+    if (ahead > NIL_CFG_TIMEDELTA && ahead <= (systime_t)-1/2) {
+      nilThdSleepS(ahead);
+    }
+    nilSysUnlock();
+  }
+  // Spin for the rest.
+  while ((int32_t)(nilTimeNowHiRes() - end) < 0) {}
+}
+//------------------------------------------------------------------------------
 #if NIL_DBG_ENABLED
 /** Debug version of port_halt */
 void port_halt(void) {
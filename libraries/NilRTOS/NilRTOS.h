@@ -33,9 +33,6 @@
 /** NilRTOS version YYYYMMDD */
 #define NIL_RTOS_VERSION 20170116
 //------------------------------------------------------------------------------
-#if NIL_CFG_TIMEDELTA
-#error tick-less mode is not supported
-#endif  // NIL_CFG_TIMEDELTA
 
 /**
  * @brief   Static semaphore initializer.
@@ -48,6 +45,36 @@
  */
 #define SEMAPHORE_DECL(name, n) semaphore_t name = {n}
 
+/**
+ * @brief   Static event flags initializer.
+ * @details Statically initialized event flags require no explicit
+ *          initialization using @p nilEvtInit().
+ *
+ * @param[in] name      the name of the event flags variable
+ */
+#define EVENT_FLAGS_DECL(name) event_flags_t name = {0}
+
+/**
+ * @brief   Static mutex initializer.
+ * @details Statically initialized mutexes require no explicit
+ *          initialization using @p nilMtxInit().
+ *
+ * @param[in] name      the name of the mutex variable
+ */
+#define MUTEX_DECL(name) mutex_t name = {NULL, 0}
+
+/**
+ * @brief   Static mailbox initializer.
+ * @details Statically initialized mailboxes require no explicit
+ *          initialization using @p nilMBInit().
+ *
+ * @param[in] name      the name of the mailbox variable
+ * @param[in] buffer    pointer to the mailbox buffer array of @p msg_t
+ * @param[in] size      number of @p msg_t elements in the buffer array
+ */
+#define MAILBOX_DECL(name, buffer, size)                                    \
+  mailbox_t name = {buffer, &buffer[size], buffer, buffer, {0}, {size}}
+
 /**
  * @brief   Delays the invoking thread for the specified number of
  *          milliseconds.
@@ -64,6 +91,47 @@
  */
 #define nilThdDelayMilliseconds(msec) nilThdDelay(MS2ST(msec))
 
+/**
+ * @brief   Returns the current time with sub-tick resolution.
+ * @details The time is a 32-bit count of @p PORT_TIME_STAMP_CYCLES CPU
+ *          cycles, four microseconds on a 16 MHz Arduino.  It combines
+ *          the system time with the timer count so it is consistent with
+ *          @p nilTimeNow().
+ * @note    The count wraps after about 4.8 hours on a 16 MHz Arduino.
+ * @note    This function can be called from any context.
+ *
+ * @return              The time in @p PORT_TIME_STAMP_CYCLES units.
+ *
+ * @api
+ */
+#define nilTimeNowHiRes() port_time_hires()
+
+/**
+ * @brief   Converts a @p nilTimeNowHiRes() interval to microseconds.
+ * @note    Intervals must be less than 2^32/PORT_TIME_STAMP_CYCLES counts.
+ *
+ * @param[in] n         the interval in @p PORT_TIME_STAMP_CYCLES units
+ * @return              The interval in microseconds.
+ *
+ * @api
+ */
+#define HR2US(n)                                                            \
+  ((uint32_t)((uint32_t)(n) * PORT_TIME_STAMP_CYCLES / (F_CPU / 1000000UL)))
+
+/**
+ * @brief   Converts microseconds to @p nilTimeNowHiRes() counts.
+ * @note    The result is rounded upward to the next count.
+ *
+ * @param[in] usec      the time in microseconds, less than
+ *                      2^32/(F_CPU/1000000)
+ * @return              The time in @p PORT_TIME_STAMP_CYCLES units.
+ *
+ * @api
+ */
+#define US2HR(usec)                                                         \
+  ((uint32_t)(((uint32_t)(usec) * (F_CPU / 1000000UL) +                     \
+               PORT_TIME_STAMP_CYCLES - 1) / PORT_TIME_STAMP_CYCLES))
+
 /**
  * @brief   Decreases the semaphore counter.
  * @details This macro can be used when the counter is known to be positive.
@@ -87,6 +155,54 @@
  * @iclass
  */
 #define nilSemGetCounterI(sp)    ((sp)->cnt)
+/**
+ * @brief   Clears event flags.
+ *
+ * @iclass
+ */
+#define nilEvtClearI(efp, mask)  ((efp)->flags &= ~(mask))
+
+/**
+ * @brief   Returns the pending event flags.
+ *
+ * @iclass
+ */
+#define nilEvtGetFlagsI(efp)     ((efp)->flags)
+/**
+ * @brief   Returns the number of free message slots in a mailbox.
+ *
+ * @iclass
+ */
+#define nilMBGetFreeCountI(mbp)  ((mbp)->emptysem.cnt < 0 ? 0 : (mbp)->emptysem.cnt)
+
+/**
+ * @brief   Returns the number of messages in a mailbox.
+ *
+ * @iclass
+ */
+#define nilMBGetUsedCountI(mbp)  ((mbp)->fullsem.cnt < 0 ? 0 : (mbp)->fullsem.cnt)
+/**
+ * @brief   Returns the number of free blocks in a memory pool.
+ *
+ * @iclass
+ */
+#define nilPoolGetFreeCountI(mp)  ((mp)->sem.cnt < 0 ? 0 : (mp)->sem.cnt)
+
+/**
+ * @brief   Returns the minimum number of free blocks in a memory pool
+ *          since it was initialized, the low-water mark.
+ *
+ * @iclass
+ */
+#define nilPoolGetMinFreeCountI(mp)  ((mp)->minfree)
+/**
+ * @brief   Returns the unused stack bytes of a thread found by the stack
+ *          monitor, the size of the working area less its high-water mark.
+ * @note    Requires @p NIL_CFG_STACK_MONITOR.
+ *
+ * @param[in] nt        the thread index
+ */
+#define nilStackMonitorUnused(nt) (nil.threads[nt].stkunused)
 /**
  * @brief   Returns true if current thread is the idle thread.
  */
@@ -94,7 +210,11 @@
 
 #ifdef __cplusplus
 #include <Arduino.h>
+void nilPrintCpuUsage(Print* pr);
+void nilPrintLockProfile(Print* pr);
+void nilPrintStackMonitor(Print* pr);
 void nilPrintStackSizes(Print* pr);
+void nilPrintTrace(Print* pr);
 void nilPrintUnusedStack(Print* pr);
 extern "C" {
 #endif
@@ -103,6 +223,7 @@ extern "C" {
   bool nilSysBegin(void);
   bool nilSysBeginNoFill();
   void nilThdDelay(systime_t time);
+  void nilThdDelayMicroseconds(uint32_t usec);
   void nilThdDelayUntil(systime_t time);
   size_t nilUnusedHeapIdle();
   size_t nilUnusedStack(uint8_t nt);
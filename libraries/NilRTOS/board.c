@@ -32,11 +32,17 @@
  * @{
  */
 #include "nil.h"
+#if NIL_CFG_TIMEDELTA == 0
+/** System time wrap count, bits 16-23 of the tick count. */
+static uint8_t port_systime_high;
+
 /** System time ISR. */
 NIL_IRQ_HANDLER(TIMER0_COMPA_vect) {
 
   NIL_IRQ_PROLOGUE();
 
+  /* Carry before the handler, timer callbacks may read the time. */
+  if (nil.systime == (systime_t)-1) port_systime_high++;
   nilSysTimerHandlerI();
 
   NIL_IRQ_EPILOGUE();
@@ -53,4 +59,113 @@ void boardInit(void) {
   OCR0A = 128;
   TIMSK0  |= (1 << OCIE0A);  /* IRQ on compare.  */
 }
+/**
+ * Time stamp with PORT_TIME_STAMP_CYCLES resolution.
+ * The high byte is the low byte of the system time and the low byte is
+ * the timer 0 count since the last tick.
+ *
+ * @return The time stamp.
+ */
+uint16_t port_time_stamp(void) {
+  uint8_t sreg = SREG;
+  uint8_t n, t;
+
+  port_disable();
+  t = TCNT0 - OCR0A;
+  n = nil.systime;
+  /* Compare match not yet serviced by the tick ISR. */
+  if ((TIFR0 & (1 << OCF0A)) && t < 128) n++;
+  SREG = sreg;
+  return ((uint16_t)n << 8) | t;
+}
+/**
+ * Time with PORT_TIME_STAMP_CYCLES resolution.
+ * The high 24 bits are the tick count and the low byte is the timer 0
+ * count since the last tick.
+ *
+ * @return The time.
+ */
+uint32_t port_time_hires(void) {
+  uint8_t sreg = SREG;
+  uint32_t n;
+  uint8_t t;
+
+  port_disable();
+  t = TCNT0 - OCR0A;
+  n = ((uint32_t)port_systime_high << 16) | nil.systime;
+  /* Compare match not yet serviced by the tick ISR. */
+  if ((TIFR0 & (1 << OCF0A)) && t < 128) n++;
+  SREG = sreg;
+  return (n << 8) | t;
+}
+#else  /* NIL_CFG_TIMEDELTA */
+/** System alarm ISR. */
+NIL_IRQ_HANDLER(TIMER1_COMPA_vect) {
+
+  NIL_IRQ_PROLOGUE();
+
+  nilSysTimerHandlerI();
+
+  NIL_IRQ_EPILOGUE();
+}
+/** Timer 1 overflow count, the high 16 bits of port_time_hires(). */
+static uint16_t port_timer_high;
+
+/**
+ * Timer 1 overflow ISR, extends the timer for port_time_hires() and
+ * keeps the CPU usage time stamp from wrapping.
+ */
+ISR(TIMER1_OVF_vect) {
+  port_timer_high++;
+#if NIL_CFG_CPU_USAGE
+  nilCpuUsageUpdateI(nil.current);
+#endif  /* NIL_CFG_CPU_USAGE */
+}
+/**
+ * Board-specific initialization code for Arduino.
+ * Use timer 1 as a free-running counter for the tick-less mode.
+ * Compare A interrupts are enabled only while a timeout is pending.
+ */
+void boardInit(void) {
+  /*
+   * Timer 1 setup, normal mode.
+   */
+  TCCR1A = 0;
+  TCCR1B = PORT_TIMER_CS;
+  /* Overflow IRQ once per timer period. */
+  TIMSK1 = (1 << TOIE1);
+  TCNT1 = 0;
+}
+/**
+ * Time stamp with PORT_TIME_STAMP_CYCLES resolution.
+ *
+ * @return The timer 1 count.
+ */
+uint16_t port_time_stamp(void) {
+  uint8_t sreg = SREG;
+  uint16_t t;
+
+  port_disable();
+  t = TCNT1;
+  SREG = sreg;
+  return t;
+}
+/**
+ * Time with PORT_TIME_STAMP_CYCLES resolution.
+ *
+ * @return The timer 1 count extended by the overflow count.
+ */
+uint32_t port_time_hires(void) {
+  uint8_t sreg = SREG;
+  uint16_t n, t;
+
+  port_disable();
+  t = TCNT1;
+  n = port_timer_high;
+  /* Overflow not yet serviced by the overflow ISR. */
+  if ((TIFR1 & (1 << TOV1)) && t < 0X8000) n++;
+  SREG = sreg;
+  return ((uint32_t)n << 16) | t;
+}
+#endif  /* NIL_CFG_TIMEDELTA */
 /** @} */
\ No newline at end of file
@@ -73,7 +73,25 @@ NIL_THREAD(Thread2, arg) {
     
     // Print unused stack for thread 1, thread 2, and idle thread.
     nilPrintUnusedStack(&Serial);
-    
+
+#if NIL_CFG_CPU_USAGE
+    // Print CPU usage for thread 1, thread 2, and idle thread.
+    // Set NIL_CFG_CPU_USAGE TRUE in nilconf.h to enable.
+    nilPrintCpuUsage(&Serial);
+#endif  // NIL_CFG_CPU_USAGE
+
+#if NIL_CFG_LOCK_PROFILE
+    // Print the longest kernel lock and a histogram of lock times.
+    // Set NIL_CFG_LOCK_PROFILE TRUE in nilconf.h to enable.
+    nilPrintLockProfile(&Serial);
+#endif  // NIL_CFG_LOCK_PROFILE
+
+#if NIL_CFG_STACK_MONITOR
+    // Print unused stack for thread 1 and thread 2 without a stack scan.
+    // Set NIL_CFG_STACK_MONITOR TRUE in nilconf.h to enable.
+    nilPrintStackMonitor(&Serial);
+#endif  // NIL_CFG_STACK_MONITOR
+
     // Zero loopCount at start of each second.
     loopCount = 0;
   }
@@ -0,0 +1,99 @@
+/* Example of event flags.
+ *
+ * One thread waits for any of three sources, a timer thread, a button
+ * on pin 2, and a serial command, with a single wait.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+#if !NIL_CFG_USE_EVENTS
+#error Set NIL_CFG_USE_EVENTS TRUE in nilconf.h
+#endif  // NIL_CFG_USE_EVENTS
+
+// Pin for button to ground.
+const uint8_t BUTTON_PIN = 2;
+
+// Event flags for the three sources.
+const eventmask_t EVT_TIMER = 1;
+const eventmask_t EVT_BUTTON = 2;
+const eventmask_t EVT_SERIAL = 4;
+
+// Declare and initialize the event flags object.
+EVENT_FLAGS_DECL(events);
+//------------------------------------------------------------------------------
+// Declare a stack with 64 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waThread1, 64);
+
+// Highest priority thread, handles all sources.
+NIL_THREAD(Thread1, arg) {
+  while (TRUE) {
+    // Wait up to two seconds for any source.
+    eventmask_t m = nilEvtWaitAnyTimeout(&events,
+                                         EVT_TIMER | EVT_BUTTON | EVT_SERIAL,
+                                         MS2ST(2000));
+    if (m == 0) {
+      Serial.println(F("timeout"));
+      continue;
+    }
+    if (m & EVT_TIMER) Serial.println(F("timer"));
+    if (m & EVT_BUTTON) Serial.println(F("button"));
+    if (m & EVT_SERIAL) {
+      Serial.print(F("serial: "));
+      while (Serial.available()) Serial.write(Serial.read());
+      Serial.println();
+    }
+  }
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 16 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waThread2, 16);
+
+// Timer source, signals every 1500 ms.
+NIL_THREAD(Thread2, arg) {
+  while (TRUE) {
+    nilThdSleepMilliseconds(1500);
+    nilEvtSignal(&events, EVT_TIMER);
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * These threads start with a null argument.  A thread's name may also
+ * be null to save RAM since the name is currently not used.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY(NULL, Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY(NULL, Thread2, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  Serial.println(F("Type a command or press the button"));
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+// Signaling event flags does not block so it is allowed.
+void loop() {
+  static bool pressed = false;
+  bool down = digitalRead(BUTTON_PIN) == LOW;
+  if (down && !pressed) nilEvtSignal(&events, EVT_BUTTON);
+  pressed = down;
+  if (Serial.available()) {
+    // Let the command arrive before signaling.
+    nilThdDelayMilliseconds(10);
+    nilEvtSignal(&events, EVT_SERIAL);
+  }
+}
@@ -7,6 +7,7 @@
  * The FIFO uses two semaphores to synchronize between threads.
  */
 #include <NilRTOS.h>
+#include <NilPeriodic.h>
 // Use NilAnalog to allow the sensor read thread to sleep during ADC conversion.
 #include <NilAnalog.h>
 #include <SdFat.h>
@@ -39,6 +40,9 @@ SdFile file;
 
 // Maximum overrun count.
 uint16_t maxOverrunCount = 0;
+
+// Drift-free release of the sensor read thread.
+NilPeriodic periodic;
 //------------------------------------------------------------------------------
 // Fifo definitions.
 
@@ -50,7 +54,7 @@ typedef uint32_t period_t;
 
 // Type for data record.
 struct FifoItem_t {
-  period_t usec;   // Point start time in usec.
+  period_t time;   // Point start time in nilTimeNowHiRes() counts.
 
   uint16_t value[NUM_ADC];  // ADC values.
 
@@ -82,14 +86,12 @@ NIL_THREAD(Thread1, arg) {
   // Count of overrun errors.
   int overrunCount = 0;
 
-  // Time for next read.
-  systime_t wakeTime = nilTimeNow();
+  // Points that are too late are skipped, the release time is not lost.
+  periodic.begin(PERIOD_TICKS, NIL_PERIODIC_SKIP);
 
   while (1) {
-    wakeTime += PERIOD_TICKS;
-
     // Sleep until time for next data point
-    nilThdSleepUntil(wakeTime);
+    periodic.waitNextPeriod();
 
     // Get an empty record.
     if (nilSemWaitTimeout(&fifoSpace, TIME_IMMEDIATE) != NIL_MSG_OK) {
@@ -105,8 +107,8 @@ NIL_THREAD(Thread1, arg) {
     // Pointer to empty record.
     FifoItem_t* p = &fifoArray[fifoHead];
 
-      // Start time in usec.
-      p->usec = micros();
+    // Start time, consistent with the RTOS clock.
+    p->time = nilTimeNowHiRes();
 
     // Read ADC data.
     for (int i = 0; i < NUM_ADC; i++) {
@@ -181,7 +183,7 @@ void setup() {
 // FIFO index for record to be written.
 size_t fifoTail = 0;
 
-// Time in micros for last point.
+// Start time of last point.
 period_t last = 0;
 
 // Maximum SD write latency for a record.
@@ -209,6 +211,7 @@ void loop() {
     Serial.print(maxLatency);
     Serial.println(F(" usec"));
     nilPrintUnusedStack(&Serial);
+    periodic.printStats(&Serial);
     if (maxOverrunCount) {
       Serial.println();
       Serial.println(F("** overrun errors **"));
@@ -236,10 +239,10 @@ void loop() {
       file.write("NA,");
     }
     else {
-      file.printField(p->usec - last, ',');
+      file.printField(HR2US((period_t)(p->time - last)), ',');
     }
     // Remember time of last data point.
-    last = p->usec;
+    last = p->time;
 
   // Print ADC values.
   for (int i = 0; i < NUM_ADC; i++) {
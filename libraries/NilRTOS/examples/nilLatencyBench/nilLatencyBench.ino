@@ -0,0 +1,280 @@
+/* Kernel latency benchmark with CSV output.
+ *
+ * Timer 1 runs with no prescale so all times are in CPU cycles.  Each
+ * test is run NSAMPLE times and one CSV line is printed per test:
+ *
+ * test,threads,ready_mask,samples,min,mean,max
+ *
+ * The threads column is the number of threads that run in a sample.
+ *
+ * sem_round_trip  Semaphore ping-pong, the bench thread signals a higher
+ *                 priority thread that signals back.  Two context switches.
+ *
+ * isr_entry       Timer 1 compare match to the first statement of the ISR.
+ *
+ * isr_to_thread   Timer 1 compare match to the first statement of a
+ *                 thread woken by a semaphore signaled in the ISR.
+ *
+ * fifo_handoff    NilFIFO signalData() in the producer to the return of
+ *                 waitData() in a higher priority consumer.
+ *
+ * switch_chain    The bench thread signals n higher priority threads with
+ *                 one reschedule.  Time until the bench thread runs again,
+ *                 n + 1 context switches, for n from one to NWORKER.
+ *
+ * Save the output of each release to track kernel performance.  Run
+ * the sketch with NIL_CFG_USE_READY_MASK TRUE and FALSE to compare the
+ * ready mask with a linear scan of the threads array.  Mutexes require
+ * the ready mask so leave NIL_CFG_USE_MUTEXES FALSE for the scan run.
+ */
+#include <NilRTOS.h>
+#include <NilFIFO.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+#if NIL_CFG_TIMEDELTA > 0
+#error Timer 1 is used by tick-less mode, set NIL_CFG_TIMEDELTA zero.
+#endif  // NIL_CFG_TIMEDELTA
+
+// Number of samples for each test.
+const uint16_t NSAMPLE = 1000;
+
+// Number of threads for the switch_chain test.
+const uint8_t NWORKER = 6;
+
+// Cycles from now to the compare match that triggers the ISR.
+const uint16_t ISR_DELAY = 200;
+//------------------------------------------------------------------------------
+// Statistics for one CSV line.
+struct result_t {
+  const __FlashStringHelper* name;
+  uint8_t threads;
+  uint16_t min;
+  uint16_t max;
+  uint32_t sum;
+};
+// One result for each test plus one for each switch_chain thread count.
+const uint8_t NRESULT = 4 + NWORKER;
+result_t result[NRESULT];
+
+// Start a result.
+void beginResult(result_t* r, const __FlashStringHelper* name,
+                 uint8_t threads) {
+  r->name = name;
+  r->threads = threads;
+  r->min = 0XFFFF;
+  r->max = 0;
+  r->sum = 0;
+}
+// Add a sample to a result.
+void addSample(result_t* r, uint16_t cycles) {
+  if (cycles < r->min) r->min = cycles;
+  if (cycles > r->max) r->max = cycles;
+  r->sum += cycles;
+}
+//------------------------------------------------------------------------------
+// Semaphores for sem_round_trip.
+SEMAPHORE_DECL(semPing, 0);
+SEMAPHORE_DECL(semPong, 0);
+
+// Declare a stack with 16 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waPong, 16);
+
+// Highest priority thread, returns each ping.
+NIL_THREAD(Pong, arg) {
+  while (TRUE) {
+    nilSemWait(&semPing);
+    nilSemSignal(&semPong);
+  }
+}
+//------------------------------------------------------------------------------
+// Semaphore signaled by the Timer 1 compare B ISR.
+SEMAPHORE_DECL(isrSem, 0);
+
+// Timer 1 count at ISR entry and handler thread start.
+volatile uint16_t tIsr;
+volatile uint16_t tHandler;
+
+NIL_IRQ_HANDLER(TIMER1_COMPB_vect) {
+  NIL_IRQ_PROLOGUE();
+  tIsr = TCNT1;
+  // One interrupt per sample.
+  TIMSK1 &= ~(1 << OCIE1B);
+  nilSysLockFromISR();
+  nilSemSignalI(&isrSem);
+  nilSysUnlockFromISR();
+  NIL_IRQ_EPILOGUE();
+}
+
+// Declare a stack with 16 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waHandler, 16);
+
+// Handler thread for the ISR.
+NIL_THREAD(Handler, arg) {
+  while (TRUE) {
+    nilSemWait(&isrSem);
+    tHandler = TCNT1;
+  }
+}
+//------------------------------------------------------------------------------
+// FIFO of Timer 1 counts for fifo_handoff.
+NilFIFO<uint16_t, 2> fifo;
+
+// Cycles for the last handoff.
+volatile uint16_t tFifo;
+
+// Declare a stack with 16 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waConsumer, 16);
+
+// Consumer thread for the FIFO.
+NIL_THREAD(Consumer, arg) {
+  while (TRUE) {
+    uint16_t* p = fifo.waitData(TIME_INFINITE);
+    tFifo = TCNT1 - *p;
+    fifo.signalFree();
+  }
+}
+//------------------------------------------------------------------------------
+// Semaphores for switch_chain, one per worker.
+semaphore_t workerSem[NWORKER];
+
+// Worker thread, the argument is its semaphore.
+NIL_THREAD(Worker, arg) {
+  while (TRUE) {
+    nilSemWait((semaphore_t*)arg);
+  }
+}
+// Declare stacks for worker threads.
+NIL_WORKING_AREA(waWorker0, 16);
+NIL_WORKING_AREA(waWorker1, 16);
+NIL_WORKING_AREA(waWorker2, 16);
+NIL_WORKING_AREA(waWorker3, 16);
+NIL_WORKING_AREA(waWorker4, 16);
+NIL_WORKING_AREA(waWorker5, 16);
+//------------------------------------------------------------------------------
+// Set true when all tests are done.
+volatile bool done = false;
+
+// Declare a stack with 64 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waBench, 64);
+
+// Lowest priority thread, runs the tests.
+NIL_THREAD(Bench, arg) {
+  result_t* r = result;
+  // Let all threads start.
+  nilThdSleep(2);
+
+  beginResult(r, F("sem_round_trip"), 2);
+  for (uint16_t i = 0; i < NSAMPLE; i++) {
+    // Don't let the system tick interrupt a sample.
+    nilThdSleep(1);
+    uint16_t t0 = TCNT1;
+    nilSemSignal(&semPing);
+    nilSemWait(&semPong);
+    addSample(r, TCNT1 - t0);
+  }
+  r++;
+
+  beginResult(r, F("isr_entry"), 1);
+  beginResult(r + 1, F("isr_to_thread"), 2);
+  for (uint16_t i = 0; i < NSAMPLE; i++) {
+    nilThdSleep(1);
+    nilSysLock();
+    OCR1B = TCNT1 + ISR_DELAY;
+    TIFR1 = 1 << OCF1B;
+    TIMSK1 |= 1 << OCIE1B;
+    nilSysUnlock();
+    // The ISR preempts this thread.
+    while (TIMSK1 & (1 << OCIE1B)) {}
+    addSample(r, tIsr - OCR1B);
+    addSample(r + 1, tHandler - OCR1B);
+  }
+  r += 2;
+
+  beginResult(r, F("fifo_handoff"), 2);
+  for (uint16_t i = 0; i < NSAMPLE; i++) {
+    nilThdSleep(1);
+    uint16_t* p = fifo.waitFree(TIME_IMMEDIATE);
+    *p = TCNT1;
+    fifo.signalData();
+    addSample(r, tFifo);
+  }
+  r++;
+
+  for (uint8_t n = 1; n <= NWORKER; n++, r++) {
+    beginResult(r, F("switch_chain"), n);
+    for (uint16_t i = 0; i < NSAMPLE; i++) {
+      nilThdSleep(1);
+      uint16_t t0 = TCNT1;
+      nilSysLock();
+      for (uint8_t k = 0; k < n; k++) nilSemSignalI(&workerSem[k]);
+      nilSchRescheduleS();
+      nilSysUnlock();
+      addSample(r, TCNT1 - t0);
+    }
+  }
+  done = true;
+  nilThdSleep(TIME_INFINITE);
+  while (TRUE) {}
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * Worker threads start with their semaphore as the argument.  A thread's
+ * name is null to save RAM since the name is currently not used.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY(NULL, Pong, NULL, waPong, sizeof(waPong))
+NIL_THREADS_TABLE_ENTRY(NULL, Handler, NULL, waHandler, sizeof(waHandler))
+NIL_THREADS_TABLE_ENTRY(NULL, Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_ENTRY(NULL, Worker, &workerSem[0], waWorker0, sizeof(waWorker0))
+NIL_THREADS_TABLE_ENTRY(NULL, Worker, &workerSem[1], waWorker1, sizeof(waWorker1))
+NIL_THREADS_TABLE_ENTRY(NULL, Worker, &workerSem[2], waWorker2, sizeof(waWorker2))
+NIL_THREADS_TABLE_ENTRY(NULL, Worker, &workerSem[3], waWorker3, sizeof(waWorker3))
+NIL_THREADS_TABLE_ENTRY(NULL, Worker, &workerSem[4], waWorker4, sizeof(waWorker4))
+NIL_THREADS_TABLE_ENTRY(NULL, Worker, &workerSem[5], waWorker5, sizeof(waWorker5))
+NIL_THREADS_TABLE_ENTRY(NULL, Bench, NULL, waBench, sizeof(waBench))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+
+  // Timer 1 normal mode, no prescale.
+  TCCR1A = 0;
+  TCCR1B = (1 << CS10);
+  TIMSK1 = 0;
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  if (!done) return;
+  Serial.println(F("test,threads,ready_mask,samples,min,mean,max"));
+  for (uint8_t i = 0; i < NRESULT; i++) {
+    result_t* r = &result[i];
+    Serial.print(r->name);
+    Serial.print(',');
+    Serial.print(r->threads);
+    Serial.print(',');
+    Serial.print(NIL_CFG_USE_READY_MASK ? 1 : 0);
+    Serial.print(',');
+    Serial.print(NSAMPLE);
+    Serial.print(',');
+    Serial.print(r->min);
+    Serial.print(',');
+    Serial.print(r->sum/NSAMPLE);
+    Serial.print(',');
+    Serial.println(r->max);
+  }
+  while (TRUE) {}
+}
@@ -0,0 +1,119 @@
+/* Example of mailboxes passing buffers by pointer.
+ *
+ * A pool of buffers is kept in a free mailbox.  The producer thread takes
+ * a buffer from the free mailbox, fills it with analog reads, and posts
+ * a pointer to the buffer in the full mailbox.  The writer thread prints
+ * the buffer and returns it to the free mailbox.  No data is copied.
+ *
+ * Pointers fit in a msg_t on AVR.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+// Number of buffers in the pool.
+const uint8_t NBUF = 4;
+
+// Number of analog reads in a buffer.
+const uint8_t NREAD = 8;
+
+// Type for a buffer.
+struct Buffer {
+  uint32_t time;
+  uint16_t data[NREAD];
+};
+
+// Buffer pool.
+Buffer pool[NBUF];
+
+// Mailbox for free buffers.
+msg_t freeSlots[NBUF];
+MAILBOX_DECL(freeMbx, freeSlots, NBUF);
+
+// Mailbox for full buffers.
+msg_t fullSlots[NBUF];
+MAILBOX_DECL(fullMbx, fullSlots, NBUF);
+
+// Count of buffers not available in time.
+volatile uint16_t overruns = 0;
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waProducer, 32);
+
+// Highest priority thread, fills a buffer every 200 ms.
+NIL_THREAD(Producer, arg) {
+  systime_t wakeTime = nilTimeNow();
+  while (TRUE) {
+    wakeTime += MS2ST(200);
+    nilThdSleepUntil(wakeTime);
+    msg_t msg;
+
+    // Don't wait for a free buffer, count an overrun.
+    if (nilMBFetchTimeout(&freeMbx, &msg, TIME_IMMEDIATE) != NIL_MSG_OK) {
+      overruns++;
+      continue;
+    }
+    Buffer* p = (Buffer*)msg;
+    p->time = millis();
+    for (uint8_t i = 0; i < NREAD; i++) {
+      p->data[i] = analogRead(0);
+    }
+    nilMBPost(&fullMbx, (msg_t)p);
+  }
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 100 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waWriter, 100);
+
+// Writer thread, prints full buffers.
+NIL_THREAD(Writer, arg) {
+  while (TRUE) {
+    msg_t msg;
+    nilMBFetch(&fullMbx, &msg);
+    Buffer* p = (Buffer*)msg;
+    Serial.print(p->time);
+    for (uint8_t i = 0; i < NREAD; i++) {
+      Serial.print(',');
+      Serial.print(p->data[i]);
+    }
+    Serial.print(F(",overruns: "));
+    Serial.println(overruns);
+
+    // Return the buffer to the pool.
+    nilMBPost(&freeMbx, msg);
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * These threads start with a null argument.  A thread's name may also
+ * be null to save RAM since the name is currently not used.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY(NULL, Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_ENTRY(NULL, Writer, NULL, waWriter, sizeof(waWriter))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+
+  // Put all buffers in the free mailbox.
+  for (uint8_t i = 0; i < NBUF; i++) {
+    nilMBPostI(&freeMbx, (msg_t)&pool[i]);
+  }
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  /* not used */
+}
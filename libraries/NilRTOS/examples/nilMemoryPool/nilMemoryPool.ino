@@ -0,0 +1,115 @@
+/* Example of a fixed-size block memory pool.
+ *
+ * An ISR style producer allocates records from a pool with the I-class
+ * allocator, fills them, and posts them to a writer thread through a
+ * mailbox.  The writer prints each record and frees it.  The free count
+ * and low-water mark of the pool are printed with each record.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+// Number of blocks in the pool.
+const uint8_t NBLOCK = 6;
+
+// Record stored in a pool block.
+struct Record {
+  uint32_t time;
+  uint16_t value;
+};
+
+// Blocks for the pool.
+Record blocks[NBLOCK];
+
+// The memory pool.
+memory_pool_t pool;
+
+// Mailbox for filled records.
+msg_t slots[NBLOCK];
+MAILBOX_DECL(mbx, slots, NBLOCK);
+
+// Count of records lost because the pool was empty.
+volatile uint16_t lost = 0;
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waProducer, 32);
+
+// Producer thread, acts like an ISR and uses I-class functions.
+NIL_THREAD(Producer, arg) {
+  systime_t wakeTime = nilTimeNow();
+  while (TRUE) {
+    wakeTime += MS2ST(50);
+    nilThdSleepUntil(wakeTime);
+    nilSysLock();
+    Record* p = (Record*)nilPoolAllocI(&pool);
+    if (p) {
+      p->time = millis();
+      p->value = analogRead(0);
+      nilMBPostI(&mbx, (msg_t)p);
+    } else {
+      lost++;
+    }
+    nilSchRescheduleS();
+    nilSysUnlock();
+  }
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 100 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waWriter, 100);
+
+// Writer thread, prints and frees records.
+NIL_THREAD(Writer, arg) {
+  while (TRUE) {
+    msg_t msg;
+    nilMBFetch(&mbx, &msg);
+    Record* p = (Record*)msg;
+    Serial.print(p->time);
+    Serial.print(',');
+    Serial.print(p->value);
+    nilPoolFree(&pool, p);
+
+    nilSysLock();
+    cnt_t n = nilPoolGetFreeCountI(&pool);
+    cnt_t low = nilPoolGetMinFreeCountI(&pool);
+    nilSysUnlock();
+    Serial.print(F(",free: "));
+    Serial.print(n);
+    Serial.print(F(",low-water: "));
+    Serial.print(low);
+    Serial.print(F(",lost: "));
+    Serial.println(lost);
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * These threads start with a null argument.  A thread's name may also
+ * be null to save RAM since the name is currently not used.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY(NULL, Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_ENTRY(NULL, Writer, NULL, waWriter, sizeof(waWriter))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+
+  // Load the pool with the blocks.
+  nilPoolInit(&pool, blocks, sizeof(Record), NBLOCK);
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  /* not used */
+}
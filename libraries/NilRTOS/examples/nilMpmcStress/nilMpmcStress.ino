@@ -0,0 +1,142 @@
+/* Stress test for NilMpmcFIFO with several producers and consumers.
+ *
+ * Three producer threads each send NRECORD numbered records.  Two
+ * consumer threads check that each producer's records arrive in order
+ * and mark them in a bit map, a record that is marked twice is an error.
+ * Threads sometimes hold a record for a tick so records are written and
+ * read out of order.
+ *
+ * At the end every record must be marked once.
+ */
+#include <NilRTOS.h>
+#include <NilFIFO.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+// Number of producer threads.
+const uint8_t NPRODUCER = 3;
+
+// Number of records from each producer.
+const uint16_t NRECORD = 1000;
+
+// Type for a data record.
+struct Record_t {
+  uint8_t producer;
+  uint16_t seq;
+};
+
+// FIFO shared by all threads.
+NilMpmcFIFO<Record_t, 8> fifo;
+
+// Bit map of received records.
+uint8_t received[NPRODUCER][(NRECORD + 7)/8];
+
+// Error counts.
+volatile uint16_t duplicateCount = 0;
+volatile uint16_t orderCount = 0;
+
+// Count of producers that are done.
+volatile uint8_t doneCount = 0;
+
+// Pseudo random number to hold records, shared by all threads.
+uint16_t seed = 1;
+bool hold() {
+  nilSysLock();
+  seed = seed*25173 + 13849;
+  bool rtn = (seed >> 13) == 0;
+  nilSysUnlock();
+  return rtn;
+}
+//------------------------------------------------------------------------------
+// Consumer thread.
+NIL_THREAD(Consumer, arg) {
+  uint16_t next[NPRODUCER] = {0};
+  while (TRUE) {
+    Record_t* p = fifo.waitData(TIME_INFINITE);
+    if (hold()) nilThdSleep(1);
+    uint8_t n = p->producer;
+    uint16_t seq = p->seq;
+    fifo.signalFree(p);
+
+    // Each producer's records are in order for one consumer.
+    if (seq < next[n]) orderCount++;
+    next[n] = seq + 1;
+    uint8_t m = 1 << (seq & 7);
+    nilSysLock();
+    if (received[n][seq >> 3] & m) duplicateCount++;
+    received[n][seq >> 3] |= m;
+    nilSysUnlock();
+  }
+}
+//------------------------------------------------------------------------------
+// Producer thread, the argument is the producer number.
+NIL_THREAD(Producer, arg) {
+  for (uint16_t seq = 0; seq < NRECORD; seq++) {
+    Record_t* p = fifo.waitFree(TIME_INFINITE);
+    p->producer = (uint8_t)(uintptr_t)arg;
+    if (hold()) nilThdSleep(1);
+    p->seq = seq;
+    fifo.signalData(p);
+  }
+  nilSysLock();
+  doneCount++;
+  nilSysUnlock();
+  nilThdSleep(TIME_INFINITE);
+  while (TRUE) {}
+}
+//------------------------------------------------------------------------------
+// Declare stacks with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waConsumer0, 32);
+NIL_WORKING_AREA(waConsumer1, 32);
+NIL_WORKING_AREA(waProducer0, 32);
+NIL_WORKING_AREA(waProducer1, 32);
+NIL_WORKING_AREA(waProducer2, 32);
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * Producers start with their number as the argument.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("cons0", Consumer, NULL, waConsumer0, sizeof(waConsumer0))
+NIL_THREADS_TABLE_ENTRY("cons1", Consumer, NULL, waConsumer1, sizeof(waConsumer1))
+NIL_THREADS_TABLE_ENTRY("prod0", Producer, (void*)0, waProducer0, sizeof(waProducer0))
+NIL_THREADS_TABLE_ENTRY("prod1", Producer, (void*)1, waProducer1, sizeof(waProducer1))
+NIL_THREADS_TABLE_ENTRY("prod2", Producer, (void*)2, waProducer2, sizeof(waProducer2))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+  Serial.println(F("NilMpmcFIFO stress test"));
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  if (doneCount < NPRODUCER || fifo.freeCount() < 8) return;
+  uint16_t lost = 0;
+  for (uint8_t n = 0; n < NPRODUCER; n++) {
+    for (uint16_t seq = 0; seq < NRECORD; seq++) {
+      if (!(received[n][seq >> 3] & (1 << (seq & 7)))) lost++;
+    }
+  }
+  Serial.print(F("Records: "));
+  Serial.println((uint32_t)NPRODUCER*NRECORD);
+  Serial.print(F("Lost: "));
+  Serial.println(lost);
+  Serial.print(F("Duplicated: "));
+  Serial.println(duplicateCount);
+  Serial.print(F("Out of order: "));
+  Serial.println(orderCount);
+  Serial.println(lost || duplicateCount || orderCount ? F("FAIL") : F("PASS"));
+  nilPrintUnusedStack(&Serial);
+  while (TRUE) {}
+}
@@ -0,0 +1,137 @@
+/* Measure worst-case blocking of a high priority thread on a shared bus.
+ *
+ * A high priority sampler and a low priority logger share a bus.  The
+ * logger holds the bus for 3 ms, like an SD block write.  A medium
+ * priority thread uses the CPU for 20 ms every 50 ms.
+ *
+ * With a semaphore the medium thread can preempt the logger while it
+ * holds the bus so the sampler may be blocked for more than 20 ms.
+ * With a mutex the logger inherits the sampler's priority and blocking
+ * is bounded by the 3 ms hold time.
+ *
+ * Set USE_MUTEX to zero to use a semaphore and compare.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+// Set nonzero to protect the bus with a mutex, zero for a semaphore.
+#define USE_MUTEX 1
+
+#if USE_MUTEX && !NIL_CFG_USE_MUTEXES
+#error Set NIL_CFG_USE_MUTEXES TRUE in nilconf.h
+#endif  // NIL_CFG_USE_MUTEXES
+
+#if USE_MUTEX
+MUTEX_DECL(bus);
+#define busLock() nilMtxLock(&bus)
+#define busUnlock() nilMtxUnlock(&bus)
+#else  // USE_MUTEX
+SEMAPHORE_DECL(bus, 1);
+#define busLock() nilSemWait(&bus)
+#define busUnlock() nilSemSignal(&bus)
+#endif  // USE_MUTEX
+
+// Worst-case and total blocking of the sampler in microseconds.
+volatile uint32_t maxBlock = 0;
+volatile uint32_t sumBlock = 0;
+volatile uint16_t nSample = 0;
+//------------------------------------------------------------------------------
+// Use the CPU for ms milliseconds.
+static void spin(uint16_t ms) {
+  uint32_t t = micros();
+  while ((micros() - t) < 1000UL*ms) {}
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waSampler, 32);
+
+// High priority sampler, uses the bus every 10 ms.
+NIL_THREAD(Sampler, arg) {
+  systime_t wakeTime = nilTimeNow();
+  while (TRUE) {
+    wakeTime += MS2ST(10);
+    nilThdSleepUntil(wakeTime);
+    uint32_t t0 = micros();
+    busLock();
+    uint32_t t = micros() - t0;
+    busUnlock();
+    nilSysLock();
+    if (t > maxBlock) maxBlock = t;
+    sumBlock += t;
+    nSample++;
+    nilSysUnlock();
+  }
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waMedium, 32);
+
+// Medium priority thread, uses the CPU for 20 ms every 50 ms.
+NIL_THREAD(Medium, arg) {
+  while (TRUE) {
+    nilThdSleepMilliseconds(30);
+    spin(20);
+  }
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waLogger, 32);
+
+// Low priority logger, holds the bus for 3 ms every 7 ms.
+NIL_THREAD(Logger, arg) {
+  while (TRUE) {
+    busLock();
+    spin(3);
+    busUnlock();
+    nilThdSleepMilliseconds(7);
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * These threads start with a null argument.  A thread's name may also
+ * be null to save RAM since the name is currently not used.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY(NULL, Sampler, NULL, waSampler, sizeof(waSampler))
+NIL_THREADS_TABLE_ENTRY(NULL, Medium, NULL, waMedium, sizeof(waMedium))
+NIL_THREADS_TABLE_ENTRY(NULL, Logger, NULL, waLogger, sizeof(waLogger))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+  Serial.println(USE_MUTEX ? F("Mutex") : F("Semaphore"));
+  Serial.println(F("Sampler blocking usec max,avg"));
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  static uint32_t last = 0;
+  if ((millis() - last) < 2000) return;
+  last = millis();
+
+  nilSysLock();
+  uint32_t m = maxBlock;
+  uint32_t s = sumBlock;
+  uint16_t n = nSample;
+  maxBlock = 0;
+  sumBlock = 0;
+  nSample = 0;
+  nilSysUnlock();
+
+  Serial.print(m);
+  Serial.print(',');
+  Serial.println(n ? s/n : 0);
+}
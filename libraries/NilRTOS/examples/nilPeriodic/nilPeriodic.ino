@@ -0,0 +1,78 @@
+/* Example of the NilPeriodic drift-free periodic thread helper.
+ *
+ * A sampler thread runs every 10 ms.  Every few seconds it takes
+ * 25 ms for a point so deadlines are missed.  Statistics are printed
+ * each second.
+ *
+ * Change POLICY to NIL_PERIODIC_SKIP to drop late points instead of
+ * running them back to back.
+ */
+#include <NilRTOS.h>
+#include <NilPeriodic.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+// Policy for late releases.
+const uint8_t POLICY = NIL_PERIODIC_CATCH_UP;
+
+// Periodic release of the sampler thread.
+NilPeriodic periodic;
+
+// Count of points.
+volatile uint32_t pointCount = 0;
+//------------------------------------------------------------------------------
+// Declare a stack with 64 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waSampler, 64);
+
+// Sampler thread, first in the table so it has the highest priority.
+NIL_THREAD(Sampler, arg) {
+  periodic.begin(MS2ST(10), POLICY);
+  while (TRUE) {
+    periodic.waitNextPeriod();
+    pointCount++;
+
+    // Simulate a slow point every 300 points.
+    if ((pointCount % 300) == 0) nilThdDelayMilliseconds(25);
+  }
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 64 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waPrinter, 64);
+
+// Printer thread, prints statistics each second.
+NIL_THREAD(Printer, arg) {
+  systime_t wakeTime = nilTimeNow();
+  while (TRUE) {
+    wakeTime += MS2ST(1000);
+    nilThdSleepUntil(wakeTime);
+    Serial.print(F("Points: "));
+    Serial.println(pointCount);
+    periodic.printStats(&Serial);
+    Serial.println();
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("sampler", Sampler, NULL, waSampler, sizeof(waSampler))
+NIL_THREADS_TABLE_ENTRY("printer", Printer, NULL, waPrinter, sizeof(waPrinter))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {}
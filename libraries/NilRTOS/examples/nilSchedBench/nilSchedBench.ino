@@ -0,0 +1,155 @@
+/* Benchmark for selection of the next ready thread.
+ *
+ * Thread 1, the highest priority thread, and the lowest priority thread
+ * exchange a semaphore while all other threads sleep.  Each time thread 1
+ * waits, the scheduler must find the lowest priority thread so this is
+ * the worst case for a linear scan of the threads array.
+ *
+ * Timer 1 runs with no prescale so times are in CPU cycles.
+ *
+ * Run this sketch with NIL_CFG_USE_READY_MASK set to TRUE in nilconf.h,
+ * then with it set to FALSE, to compare the ready mask with a linear
+ * scan of the threads array.  Change the number of sleeping threads
+ * by editing the threads table.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+// Number of round trips to time.
+const uint16_t NSAMPLE = 1000;
+
+// Semaphore to wake thread 1.
+SEMAPHORE_DECL(sem, 0);
+
+// Timer 1 count when thread 1 is switched in.
+volatile uint16_t tIn;
+
+// Minimum, maximum, and total cycles for switch in and switch out.
+uint16_t minIn = 0XFFFF;
+uint16_t maxIn = 0;
+uint32_t sumIn = 0;
+uint16_t minOut = 0XFFFF;
+uint16_t maxOut = 0;
+uint32_t sumOut = 0;
+
+// Set true when done.
+volatile bool done = false;
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waThread1, 32);
+
+// Highest priority thread, saves time and waits again.
+NIL_THREAD(Thread1, arg) {
+  while (TRUE) {
+    nilSemWait(&sem);
+    tIn = TCNT1;
+  }
+}
+//------------------------------------------------------------------------------
+// Threads that sleep forever so they are skipped by the scheduler.
+NIL_THREAD(Sleeper, arg) {
+  nilThdSleep(TIME_INFINITE);
+  while (TRUE) {}
+}
+// Declare stacks for sleeping threads.
+NIL_WORKING_AREA(waSleep2, 16);
+NIL_WORKING_AREA(waSleep3, 16);
+NIL_WORKING_AREA(waSleep4, 16);
+NIL_WORKING_AREA(waSleep5, 16);
+NIL_WORKING_AREA(waSleep6, 16);
+NIL_WORKING_AREA(waSleep7, 16);
+NIL_WORKING_AREA(waSleep8, 16);
+NIL_WORKING_AREA(waSleep9, 16);
+NIL_WORKING_AREA(waSleep10, 16);
+NIL_WORKING_AREA(waSleep11, 16);
+//------------------------------------------------------------------------------
+// Declare a stack with 64 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waLow, 64);
+
+// Lowest priority thread, wakes thread 1 and times both switches.
+NIL_THREAD(Low, arg) {
+  // Let all threads start.
+  nilThdSleep(2);
+  for (uint16_t i = 0; i < NSAMPLE; i++) {
+    // Don't let the system tick interrupt a sample.
+    nilThdSleep(1);
+    uint16_t t0 = TCNT1;
+    nilSemSignal(&sem);
+    uint16_t t1 = TCNT1;
+    uint16_t in = tIn - t0;
+    uint16_t out = t1 - tIn;
+    if (in < minIn) minIn = in;
+    if (in > maxIn) maxIn = in;
+    sumIn += in;
+    if (out < minOut) minOut = out;
+    if (out > maxOut) maxOut = out;
+    sumOut += out;
+  }
+  done = true;
+  nilThdSleep(TIME_INFINITE);
+  while (TRUE) {}
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * These threads start with a null argument.  A thread's name is also
+ * null to save RAM since the name is currently not used.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY(NULL, Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep2, sizeof(waSleep2))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep3, sizeof(waSleep3))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep4, sizeof(waSleep4))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep5, sizeof(waSleep5))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep6, sizeof(waSleep6))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep7, sizeof(waSleep7))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep8, sizeof(waSleep8))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep9, sizeof(waSleep9))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep10, sizeof(waSleep10))
+NIL_THREADS_TABLE_ENTRY(NULL, Sleeper, NULL, waSleep11, sizeof(waSleep11))
+NIL_THREADS_TABLE_ENTRY(NULL, Low, NULL, waLow, sizeof(waLow))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+
+  // Timer 1 normal mode, no prescale.
+  TCCR1A = 0;
+  TCCR1B = (1 << CS10);
+  TIMSK1 = 0;
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  if (!done) return;
+  Serial.print(F("Ready mask: "));
+  Serial.println(NIL_CFG_USE_READY_MASK ? F("TRUE") : F("FALSE"));
+  Serial.print(F("Thread count: "));
+  Serial.println(nil_thd_count);
+  Serial.println(F("Cycles min,avg,max"));
+  Serial.print(F("Signal to wake: "));
+  Serial.print(minIn);
+  Serial.print(',');
+  Serial.print(sumIn/NSAMPLE);
+  Serial.print(',');
+  Serial.println(maxIn);
+  Serial.print(F("Wait to switch out: "));
+  Serial.print(minOut);
+  Serial.print(',');
+  Serial.print(sumOut/NSAMPLE);
+  Serial.print(',');
+  Serial.println(maxOut);
+  while (TRUE) {}
+}
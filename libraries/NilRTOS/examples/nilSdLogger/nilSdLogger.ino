@@ -29,10 +29,13 @@ struct Record_t {
   uint16_t adc[NADC];
 };
 
-// Number of data records in the FIFO.
-const size_t FIFO_DIM = FIFO_SIZE_BYTES/sizeof(Record_t);
+// Number of data records in the FIFO, latency time stamps use three bytes.
+const size_t FIFO_DIM =
+  FIFO_SIZE_BYTES/(sizeof(Record_t) + (NIL_CFG_FIFO_LATENCY ? 3 : 0));
 
 // Declare FIFO with overrun and minimum free space statistics.
+// Set NIL_CFG_FIFO_LATENCY TRUE in nilconf.h to print a histogram of
+// the time records wait in the FIFO for the SD.
 NilStatsFIFO<Record_t, FIFO_DIM> fifo;
 //------------------------------------------------------------------------------
 // SD card chip select pin.
@@ -141,44 +144,53 @@ void setup() {
 // Loop is the idle thread.  The idle thread must not invoke any
 // kernel primitive able to change its state to not runnable.
 void loop() {
+#if !NIL_CFG_FIFO_LATENCY
   // Maximum SD write latency.
   uint32_t maxLatency = 0;
+#endif  // !NIL_CFG_FIFO_LATENCY
 
   // Record data until serial data is available()
   while (!Serial.available()) {
 
-    // Check for an available data record in the FIFO.
-    Record_t* p = fifo.waitData(TIME_IMMEDIATE);
+    // Check for available data records in the FIFO.
+    size_t n;
+    Record_t* span = fifo.waitDataSpan(FIFO_DIM, TIME_IMMEDIATE, &n);
 
     // Continue if no available data records in the FIFO.
-    if (!p) continue;
-
-    // Write start time.
-    uint32_t u = micros();
-
-    // Overruns are in the high 6-bits of adc[0].
-    uint16_t overruns = p->adc[0] >> 10;
-    p->adc[0] &= 0X3FF;
-
-    for (int i = 0; i < NADC; i++) {
-      // Print ADC value and a comma.
-      file.printField(p->adc[i], ',');
+    if (!span) continue;
+
+    for (Record_t* p = span; p < span + n; p++) {
+#if !NIL_CFG_FIFO_LATENCY
+      // Write start time.
+      uint32_t u = micros();
+#endif  // !NIL_CFG_FIFO_LATENCY
+
+      // Overruns are in the high 6-bits of adc[0].
+      uint16_t overruns = p->adc[0] >> 10;
+      p->adc[0] &= 0X3FF;
+
+      for (int i = 0; i < NADC; i++) {
+        // Print ADC value and a comma.
+        file.printField(p->adc[i], ',');
+      }
+      // Print overrun count and CR/LF.
+      file.printField(overruns, '\n');
+#if !NIL_CFG_FIFO_LATENCY
+      u = micros() - u;
+      if (u > maxLatency) maxLatency = u;
+#endif  // !NIL_CFG_FIFO_LATENCY
     }
-    // Print overrun count and CR/LF.
-    file.printField(overruns, '\n');
-
-    u = micros() - u;
-    if (u > maxLatency) maxLatency = u;
-
-    // Signal the read thread that the record is free.
-    fifo.signalFree();
+    // Signal the read thread that the records are free.
+    fifo.signalFree(n);
   }
   // Done, close the file and print stats.
   file.close();
   Serial.println(F("Done!"));
+#if !NIL_CFG_FIFO_LATENCY
   Serial.print(F("Max Write Latency: "));
   Serial.print(maxLatency);
   Serial.println(F(" usec"));
+#endif  // !NIL_CFG_FIFO_LATENCY
   nilPrintUnusedStack(&Serial);
   fifo.printStats(&Serial);
   while (1) {}
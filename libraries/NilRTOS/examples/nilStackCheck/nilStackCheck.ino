@@ -0,0 +1,71 @@
+/* Example of the stack overflow check.
+ *
+ * Set NIL_CFG_STACK_CHECK to TRUE in nilconf.h to run this example.
+ *
+ * A thread recurses one level deeper each second.  When its stack
+ * overflows the guard word at the bottom of its working area, the
+ * system halts at the next context switch and the debug version of
+ * port_halt() prints the thread name on the serial port.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+#if !NIL_CFG_STACK_CHECK
+#error Set NIL_CFG_STACK_CHECK TRUE in nilconf.h
+#endif  // NIL_CFG_STACK_CHECK
+
+// Current recursion depth.
+volatile uint8_t depth = 0;
+//------------------------------------------------------------------------------
+// Uses about 20 bytes of stack per level.
+uint8_t recurse(uint8_t n) {
+  volatile uint8_t buf[16];
+  buf[0] = n;
+  return n ? recurse(n - 1) + buf[0] : 0;
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 64 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waGreedy, 64);
+
+// Thread with a growing stack.
+NIL_THREAD(Greedy, arg) {
+  while (TRUE) {
+    recurse(depth++);
+    nilThdSleepMilliseconds(1000);
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * The thread name is printed when an overflow is detected.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("greedy", Greedy, NULL, waGreedy, sizeof(waGreedy))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  static uint8_t last = 0;
+  if (depth == last) return;
+  last = depth;
+  Serial.print(F("depth: "));
+  Serial.print(last);
+  Serial.print(F(", unused stack: "));
+  Serial.println(nilUnusedStack(0));
+}
@@ -0,0 +1,79 @@
+/* Example of the kernel event trace.
+ *
+ * Set NIL_CFG_TRACE to TRUE in nilconf.h to run this example.
+ *
+ * Two threads exchange a semaphore for a while, then the trace buffer
+ * is printed.  Save the output in a file and convert it to Chrome trace
+ * JSON with the decoder in the extras folder:
+ *
+ *   python3 NilTraceDecode.py dump.txt > trace.json
+ *
+ * View trace.json with chrome://tracing or ui.perfetto.dev.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+#if !NIL_CFG_TRACE
+#error Set NIL_CFG_TRACE TRUE in nilconf.h
+#endif  // NIL_CFG_TRACE
+
+// Semaphore to wake the consumer thread.
+SEMAPHORE_DECL(sem, 0);
+
+// Set true when the trace should be printed.
+volatile bool done = false;
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waConsumer, 32);
+
+// High priority thread, waits for the semaphore.
+NIL_THREAD(Consumer, arg) {
+  while (TRUE) {
+    nilSemWait(&sem);
+  }
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 32 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waProducer, 32);
+
+// Low priority thread, signals the semaphore then sleeps.
+NIL_THREAD(Producer, arg) {
+  for (uint8_t i = 0; i < 10; i++) {
+    nilSemSignal(&sem);
+    nilThdSleep(2);
+  }
+  done = true;
+  nilThdSleep(TIME_INFINITE);
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ *
+ * Thread names are printed with the trace.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("consumer", Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_ENTRY("producer", Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+
+  // Start kernel.
+  nilSysBegin();
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {
+  if (!done) return;
+  nilPrintTrace(&Serial);
+  while (TRUE) {}
+}
@@ -0,0 +1,90 @@
+/* Example of virtual timers.
+ *
+ * A periodic timer blinks the LED and a one-shot timer is a timeout for
+ * a reply on the serial port.  Timer callbacks run in the system timer
+ * ISR so they need no stack of their own.
+ *
+ * Type a character within two seconds of the prompt to cancel the
+ * timeout.
+ */
+#include <NilRTOS.h>
+
+// Use tiny unbuffered NilRTOS NilSerial library.
+#include <NilSerial.h>
+
+// Macro to redefine Serial as NilSerial to save RAM.
+// Remove definition to use standard Arduino Serial.
+#define Serial NilSerial
+
+#if !NIL_CFG_USE_VIRTUAL_TIMERS
+#error Set NIL_CFG_USE_VIRTUAL_TIMERS TRUE in nilconf.h
+#endif  // NIL_CFG_USE_VIRTUAL_TIMERS
+
+// The LED is attached to pin 13 on Arduino.
+const uint8_t LED_PIN = 13;
+
+// Timers are zero initialized as static variables.
+virtual_timer_t blinkTimer;
+virtual_timer_t replyTimer;
+
+// Signaled by the reply timer.
+SEMAPHORE_DECL(timeoutSem, 0);
+//------------------------------------------------------------------------------
+// Blink callback, runs in the timer ISR every 250 ms.
+void blink(void* arg) {
+  digitalWrite(LED_PIN, !digitalRead(LED_PIN));
+}
+//------------------------------------------------------------------------------
+// Timeout callback, only I-class functions may be called.
+void replyTimeout(void* arg) {
+  nilSemSignalI((semaphore_t*)arg);
+}
+//------------------------------------------------------------------------------
+// Declare a stack with 64 bytes beyond context switch and interrupt needs.
+NIL_WORKING_AREA(waPrompt, 64);
+
+// Prompt thread, polls for a reply until the reply timer expires.
+NIL_THREAD(Prompt, arg) {
+  while (TRUE) {
+    Serial.println(F("Type a character"));
+
+    // Clear a signal from a timeout that expired before it was reset.
+    nilSemReset(&timeoutSem, 0);
+    nilVTSet(&replyTimer, MS2ST(2000), 0, replyTimeout, &timeoutSem);
+    while (!Serial.available()) {
+      if (nilSemWaitTimeout(&timeoutSem, MS2ST(10)) == NIL_MSG_OK) break;
+    }
+    if (Serial.available()) {
+      // Cancel the timeout.
+      nilVTReset(&replyTimer);
+      Serial.print(F("Reply: "));
+      Serial.println((char)Serial.read());
+    } else {
+      Serial.println(F("Timeout"));
+    }
+    nilThdSleepMilliseconds(1000);
+  }
+}
+//------------------------------------------------------------------------------
+/*
+ * Threads static table, one entry per thread.  A thread's priority is
+ * determined by its position in the table with highest priority first.
+ */
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("prompt", Prompt, NULL, waPrompt, sizeof(waPrompt))
+NIL_THREADS_TABLE_END()
+//------------------------------------------------------------------------------
+void setup() {
+  Serial.begin(9600);
+  pinMode(LED_PIN, OUTPUT);
+
+  // Start kernel.
+  nilSysBegin();
+
+  // Blink forever, first callback after 250 ms then every 250 ms.
+  nilVTSet(&blinkTimer, MS2ST(250), MS2ST(250), blink, NULL);
+}
+//------------------------------------------------------------------------------
+// Loop is the idle thread.  The idle thread must not invoke any
+// kernel primitive able to change its state to not runnable.
+void loop() {}
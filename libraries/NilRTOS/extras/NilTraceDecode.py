@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Convert a nilPrintTrace() dump to Chrome trace JSON.
+
+Usage:
+    python3 NilTraceDecode.py dump.txt > trace.json
+
+Capture the serial output of nilPrintTrace() in dump.txt, other lines
+are ignored.  Open trace.json with chrome://tracing or ui.perfetto.dev.
+
+Each thread is a track with a slice for each interval it was running.
+IRQ handlers are shown on a separate IRQ track.  Wakeups and semaphore
+operations are instant events on the thread's track.
+
+Time stamps are 16 bits, gaps between events longer than 65535 counts
+(about 262 msec with a 16 MHz CPU in tick mode) are not detected.
+"""
+import json
+import sys
+
+SWITCH, READY, SEM_WAIT, SEM_SIGNAL, IRQ_ENTER, IRQ_EXIT = range(1, 7)
+
+# Thread states from nil.h.
+STATES = {0: "preempted", 1: "sleeping", 2: "suspended", 3: "semaphore",
+          4: "event any", 5: "event all", 6: "mutex"}
+
+IRQ_TID = 255
+
+
+def decode(lines):
+    fcpu = None
+    cycles = None
+    names = {}
+    events = []
+    for line in lines:
+        f = line.strip().split(",")
+        if f[0] == "NilTrace" and len(f) == 3:
+            fcpu = int(f[1])
+            cycles = int(f[2])
+        elif f[0] == "T" and len(f) == 3:
+            names[int(f[1])] = f[2]
+        elif f[0] == "E" and len(f) == 5:
+            events.append([int(x) for x in f[1:]])
+    if fcpu is None:
+        raise ValueError("no NilTrace header found")
+    usec_per_count = cycles * 1e6 / fcpu
+
+    out = []
+    for tid, name in sorted(names.items()):
+        out.append({"ph": "M", "name": "thread_name", "pid": 0, "tid": tid,
+                    "args": {"name": "%d %s" % (tid, name)}})
+        out.append({"ph": "M", "name": "thread_sort_index", "pid": 0,
+                    "tid": tid, "args": {"sort_index": tid}})
+    out.append({"ph": "M", "name": "thread_name", "pid": 0, "tid": IRQ_TID,
+                "args": {"name": "IRQ"}})
+
+    count = 0
+    last = None
+    running = None
+    start = 0.0
+    irq_depth = 0
+    for time, etype, thd, arg in events:
+        if last is not None:
+            count += (time - last) & 0XFFFF
+        last = time
+        ts = count * usec_per_count
+        if etype == SWITCH:
+            old = arg >> 8
+            if running is None:
+                running = old
+            out.append({"ph": "X", "name": "run", "pid": 0, "tid": running,
+                        "ts": start, "dur": ts - start,
+                        "args": {"out": STATES.get(arg & 0XFF,
+                                                   "state %d" % (arg & 0XFF))}})
+            running = thd
+            start = ts
+        elif etype == READY:
+            msg = arg - 0X10000 if arg & 0X8000 else arg
+            out.append({"ph": "i", "s": "t", "name": "ready", "pid": 0,
+                        "tid": thd, "ts": ts, "args": {"msg": msg}})
+        elif etype in (SEM_WAIT, SEM_SIGNAL):
+            name = "sem wait" if etype == SEM_WAIT else "sem signal"
+            out.append({"ph": "i", "s": "t", "name": name, "pid": 0,
+                        "tid": thd, "ts": ts, "args": {"sem": "0X%04X" % arg}})
+        elif etype == IRQ_ENTER:
+            irq_depth += 1
+            out.append({"ph": "B", "name": "irq", "pid": 0, "tid": IRQ_TID,
+                        "ts": ts, "args": {"thread": thd}})
+        elif etype == IRQ_EXIT and irq_depth:
+            irq_depth -= 1
+            out.append({"ph": "E", "pid": 0, "tid": IRQ_TID, "ts": ts})
+        if running is None and etype != SWITCH:
+            running = thd
+    if running is not None and last is not None:
+        ts = count * usec_per_count
+        out.append({"ph": "X", "name": "run", "pid": 0, "tid": running,
+                    "ts": start, "dur": ts - start})
+    return {"traceEvents": out, "displayTimeUnit": "ns"}
+
+
+def main():
+    if len(sys.argv) > 2:
+        sys.exit(__doc__)
+    f = open(sys.argv[1]) if len(sys.argv) == 2 else sys.stdin
+    json.dump(decode(f), sys.stdout, indent=1)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()
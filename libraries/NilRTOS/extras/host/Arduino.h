@@ -0,0 +1,47 @@
+/**
+ * @file    Arduino.h
+ * @brief   Minimal Arduino API for the host port.
+ * @details Enough of Print for the NilRTOS.h and NilFIFO.h C++ classes.
+ *          Output goes to a stdio stream.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define F(s) (s)
+#define DEC 10
+#define HEX 16
+
+class Print {
+ public:
+  explicit Print(FILE* stream = stdout) : _stream(stream) {}
+  size_t print(const char* s) {return fprintf(_stream, "%s", s);}
+  size_t print(char c) {return fprintf(_stream, "%c", c);}
+  size_t print(int n, int base = DEC) {return print((long)n, base);}
+  size_t print(unsigned n, int base = DEC) {
+    return print((unsigned long)n, base);
+  }
+  size_t print(long n, int base = DEC) {
+    return fprintf(_stream, base == HEX ? "%lX" : "%ld", n);
+  }
+  size_t print(unsigned long n, int base = DEC) {
+    return fprintf(_stream, base == HEX ? "%lX" : "%lu", n);
+  }
+  size_t print(double d, int digits = 2) {
+    return fprintf(_stream, "%.*f", digits, d);
+  }
+  size_t println() {return fprintf(_stream, "\n");}
+  template<typename T> size_t println(T v) {
+    size_t n = print(v);
+    return n + println();
+  }
+  template<typename T> size_t println(T v, int fmt) {
+    size_t n = print(v, fmt);
+    return n + println();
+  }
+ private:
+  FILE* _stream;
+};
+#endif  // Arduino_h
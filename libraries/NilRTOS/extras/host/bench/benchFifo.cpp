@@ -0,0 +1,48 @@
+// NilFIFO throughput, the producer has the higher priority so the
+// consumer runs when the FIFO is full.
+#include "hostBench.h"
+#include "NilFIFO.h"
+
+static NilFIFO<uint32_t, 16> fifo;
+static double elapsed;
+static uint32_t sum;
+
+NIL_WORKING_AREA(waProducer, 0);
+NIL_THREAD(Producer, arg) {
+  (void)arg;
+  double t0 = benchNow();
+  for (uint32_t i = 0; i < BENCH_COUNT; i++) {
+    uint32_t* p = fifo.waitFree(TIME_INFINITE);
+    *p = i;
+    fifo.signalData();
+  }
+  // Wait for the consumer to empty the FIFO.
+  while (fifo.freeCount() != 16) {
+    nilThdSleep(1);
+  }
+  elapsed = benchNow() - t0;
+  nilThdSleep(TIME_INFINITE);
+}
+
+NIL_WORKING_AREA(waConsumer, 0);
+NIL_THREAD(Consumer, arg) {
+  (void)arg;
+  for (;;) {
+    uint32_t* p = fifo.waitData(TIME_INFINITE);
+    sum += *p;
+    fifo.signalFree();
+  }
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("producer", Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_ENTRY("consumer", Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_END()
+
+int main() {
+  nilSysBegin();
+  // Let the consumer finish.
+  port_sim_run(1);
+  benchPrint("NilFIFO record", elapsed, BENCH_COUNT);
+  return 0;
+}
@@ -0,0 +1,43 @@
+/* Mailbox throughput, the consumer has the higher priority. */
+#include "hostBench.h"
+
+#define MB_SIZE 16
+
+static msg_t mbBuf[MB_SIZE];
+static MAILBOX_DECL(mb, mbBuf, MB_SIZE);
+static double elapsed;
+static msg_t sum;
+
+NIL_WORKING_AREA(waConsumer, 0);
+NIL_THREAD(Consumer, arg) {
+  msg_t msg;
+  (void)arg;
+  for (;;) {
+    nilMBFetch(&mb, &msg);
+    sum += msg;
+  }
+}
+
+NIL_WORKING_AREA(waProducer, 0);
+NIL_THREAD(Producer, arg) {
+  unsigned long i;
+  double t0;
+  (void)arg;
+  t0 = benchNow();
+  for (i = 0; i < BENCH_COUNT; i++) {
+    nilMBPost(&mb, (msg_t)i);
+  }
+  elapsed = benchNow() - t0;
+  nilThdSleep(TIME_INFINITE);
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("consumer", Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_ENTRY("producer", Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  nilSysBegin();
+  benchPrint("mailbox post+fetch", elapsed, BENCH_COUNT);
+  return 0;
+}
@@ -0,0 +1,50 @@
+/* Semaphore ping-pong, two context switches per round trip. */
+#include "hostBench.h"
+
+static SEMAPHORE_DECL(semPing, 0);
+static SEMAPHORE_DECL(semPong, 0);
+static double elapsed;
+static double elapsedSignal;
+
+NIL_WORKING_AREA(waPong, 0);
+NIL_THREAD(Pong, arg) {
+  (void)arg;
+  for (;;) {
+    nilSemWait(&semPing);
+    nilSemSignal(&semPong);
+  }
+}
+
+NIL_WORKING_AREA(waPing, 0);
+NIL_THREAD(Ping, arg) {
+  unsigned long i;
+  double t0;
+  (void)arg;
+  t0 = benchNow();
+  for (i = 0; i < BENCH_COUNT; i++) {
+    nilSemSignal(&semPing);
+    nilSemWait(&semPong);
+  }
+  elapsed = benchNow() - t0;
+
+  /* Signal and wait with no switch.*/
+  t0 = benchNow();
+  for (i = 0; i < BENCH_COUNT; i++) {
+    nilSemSignal(&semPong);
+    nilSemWait(&semPong);
+  }
+  elapsedSignal = benchNow() - t0;
+  nilThdSleep(TIME_INFINITE);
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("pong", Pong, NULL, waPong, sizeof(waPong))
+NIL_THREADS_TABLE_ENTRY("ping", Ping, NULL, waPing, sizeof(waPing))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  nilSysBegin();
+  benchPrint("semaphore round trip", elapsed, BENCH_COUNT);
+  benchPrint("semaphore signal+wait", elapsedSignal, BENCH_COUNT);
+  return 0;
+}
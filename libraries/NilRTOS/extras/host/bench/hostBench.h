@@ -0,0 +1,35 @@
+/**
+ * @file    hostBench.h
+ * @brief   Timing helpers for the host port benchmarks.
+ * @details Benchmarks run at full speed within one virtual tick, results
+ *          are wall clock nsec per operation on the host.
+ */
+#ifndef hostBench_h
+#define hostBench_h
+#include <stdio.h>
+#include <time.h>
+#include "NilRTOS.h"
+
+/** Number of operations in each benchmark. */
+#ifndef BENCH_COUNT
+#define BENCH_COUNT 1000000UL
+#endif
+
+/** @return host monotonic time in nsec. */
+static inline double benchNow(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Print a benchmark result.
+ *
+ * @param[in] name  benchmark name
+ * @param[in] ns    elapsed nsec
+ * @param[in] n     number of operations
+ */
+static inline void benchPrint(const char* name, double ns, unsigned long n) {
+  printf("%-28s %8.1f ns/op %10.0f op/s\n", name, ns / n, n * 1e9 / ns);
+}
+#endif  // hostBench_h
@@ -0,0 +1,42 @@
+/**
+ * @file    nilconf_debug.h
+ * @brief   Host test configuration with all debug options.
+ * @details Library configuration with assertions, stack check, stack
+ *          monitor, trace, lock profile and CPU usage accounting enabled.
+ *          Optional kernel objects are enabled so their tests run.
+ */
+#ifndef _NILCONF_DEBUG_H_
+#define _NILCONF_DEBUG_H_
+#include "nilconf.h"
+
+#undef  NIL_CFG_TRACE
+#define NIL_CFG_TRACE                       TRUE
+
+#undef  NIL_CFG_CPU_USAGE
+#define NIL_CFG_CPU_USAGE                   TRUE
+
+#undef  NIL_CFG_LOCK_PROFILE
+#define NIL_CFG_LOCK_PROFILE                TRUE
+
+#undef  NIL_CFG_FIFO_LATENCY
+#define NIL_CFG_FIFO_LATENCY                TRUE
+
+#undef  NIL_CFG_STACK_CHECK
+#define NIL_CFG_STACK_CHECK                 TRUE
+
+#undef  NIL_CFG_STACK_MONITOR
+#define NIL_CFG_STACK_MONITOR               TRUE
+
+#undef  NIL_CFG_USE_EVENTS
+#define NIL_CFG_USE_EVENTS                  TRUE
+
+#undef  NIL_CFG_USE_MUTEXES
+#define NIL_CFG_USE_MUTEXES                 TRUE
+
+#undef  NIL_CFG_USE_VIRTUAL_TIMERS
+#define NIL_CFG_USE_VIRTUAL_TIMERS          TRUE
+
+#undef  NIL_CFG_ENABLE_ASSERTS
+#define NIL_CFG_ENABLE_ASSERTS              TRUE
+
+#endif  /* _NILCONF_DEBUG_H_ */
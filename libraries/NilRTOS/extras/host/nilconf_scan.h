@@ -0,0 +1,18 @@
+/**
+ * @file    nilconf_scan.h
+ * @brief   Host test configuration without thread masks.
+ * @details Library configuration with the ready mask disabled so the
+ *          scheduler and semaphores scan the threads array, and
+ *          assertions enabled.  More than 15 user threads are allowed.
+ */
+#ifndef _NILCONF_SCAN_H_
+#define _NILCONF_SCAN_H_
+#include "nilconf.h"
+
+#undef  NIL_CFG_USE_READY_MASK
+#define NIL_CFG_USE_READY_MASK              FALSE
+
+#undef  NIL_CFG_ENABLE_ASSERTS
+#define NIL_CFG_ENABLE_ASSERTS              TRUE
+
+#endif  /* _NILCONF_SCAN_H_ */
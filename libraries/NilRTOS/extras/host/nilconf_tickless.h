@@ -0,0 +1,30 @@
+/**
+ * @file    nilconf_tickless.h
+ * @brief   Host test configuration for tick-less mode.
+ * @details Library configuration with a 4 usec timer count like the
+ *          nilconf.h tick-less example, assertions and optional kernel
+ *          objects enabled.
+ */
+#ifndef _NILCONF_TICKLESS_H_
+#define _NILCONF_TICKLESS_H_
+#include "nilconf.h"
+
+#undef  NIL_CFG_FREQUENCY
+#define NIL_CFG_FREQUENCY                   (F_CPU/64)
+
+#undef  NIL_CFG_TIMEDELTA
+#define NIL_CFG_TIMEDELTA                   4
+
+#undef  NIL_CFG_USE_EVENTS
+#define NIL_CFG_USE_EVENTS                  TRUE
+
+#undef  NIL_CFG_USE_MUTEXES
+#define NIL_CFG_USE_MUTEXES                 TRUE
+
+#undef  NIL_CFG_USE_VIRTUAL_TIMERS
+#define NIL_CFG_USE_VIRTUAL_TIMERS          TRUE
+
+#undef  NIL_CFG_ENABLE_ASSERTS
+#define NIL_CFG_ENABLE_ASSERTS              TRUE
+
+#endif  /* _NILCONF_TICKLESS_H_ */
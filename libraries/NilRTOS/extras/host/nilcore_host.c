@@ -0,0 +1,272 @@
+/*
+    Nil RTOS - Copyright (C) 2012 Giovanni Di Sirio.
+
+    This file is part of Nil RTOS.
+
+    Nil RTOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Nil RTOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    nilcore_host.c
+ * @brief   Linux host port code.
+ * @details The simulation runs in one Linux thread.  The program's main()
+ *          is the idle thread, it starts the kernel with @p nilSysInit()
+ *          and then advances time with @p port_sim_run().  Each simulated
+ *          tick runs the timer ISR code, so all threads run until they
+ *          wait before the next tick.
+ *
+ * @addtogroup HOST_CORE
+ * @{
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nil.h"
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/** @brief Kernel lock nesting count, one while the kernel is locked. */
+int port_lock_count;
+
+/** @brief Virtual time, ticks in tick mode else timer counts. */
+uint32_t port_sim_counter;
+
+/** @brief Test ISR run by @p port_sim_tick() for each tick or count. */
+void (*port_sim_tick_hook)(void);
+
+#if NIL_CFG_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/** @brief Simulated timer compare value. */
+systime_t port_sim_alarm;
+
+/** @brief Simulated timer compare interrupt enable. */
+bool port_sim_alarm_on;
+#endif
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/** @brief Context of the idle thread, the program's main(). */
+static struct port_intctx idle_ctx;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Start of a new thread.
+ * @details A thread is first switched in from @p nilSchGoSleepTimeoutS()
+ *          or @p nilSchRescheduleS() with the kernel locked.
+ */
+static void port_thread_start(void) {
+  struct port_intctx *ctxp = nil.current->ctxp;
+
+  nilSysUnlock();
+  ctxp->pf(ctxp->arg);
+
+  /* Thread functions must not return.*/
+  port_halt();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Creates the context of a new thread.
+ * @details The context is at the top of the working area and the rest of
+ *          the working area is the thread stack, the stack guard is at the
+ *          bottom.
+ *
+ * @param[in] tp        pointer to the thread
+ * @param[in] wsp       pointer to the working area
+ * @param[in] size      size of the working area
+ * @param[in] pf        the thread function
+ * @param[in] arg       the thread function argument
+ */
+void _port_setup_context(thread_t *tp, void *wsp, size_t size,
+                         tfunc_t pf, void *arg) {
+  struct port_intctx *ctxp = (struct port_intctx *)((uint8_t *)wsp + size -
+                                                    sizeof(struct port_intctx));
+
+  getcontext(&ctxp->uc);
+  ctxp->uc.uc_stack.ss_sp = wsp;
+  ctxp->uc.uc_stack.ss_size = (uint8_t *)ctxp - (uint8_t *)wsp;
+  ctxp->uc.uc_link = NULL;
+  ctxp->pf = pf;
+  ctxp->arg = arg;
+  makecontext(&ctxp->uc, port_thread_start, 0);
+  tp->ctxp = ctxp;
+}
+
+/**
+ * @brief   Performs a context switch between two threads.
+ *
+ * @param[in] ntp       the thread to be switched in
+ * @param[in] otp       the thread to be switched out
+ */
+void _port_switch(thread_t *ntp, thread_t *otp) {
+
+  /* The kernel must be locked exactly once across a switch.*/
+  if (port_lock_count != 1) {
+    fprintf(stderr, "port_switch: lock count %d\n", port_lock_count);
+    port_halt();
+  }
+  if (otp->ctxp == NULL)
+    otp->ctxp = &idle_ctx;
+  swapcontext(&otp->ctxp->uc, &ntp->ctxp->uc);
+}
+
+/**
+ * @brief   Halts the system.
+ * @details Prints the debug message, if any, and aborts the program.
+ * @note    The function is declared as a weak symbol, it is possible to
+ *          redefine it in your application code.
+ */
+#if !defined(__DOXYGEN__)
+__attribute__((weak))
+#endif
+void port_halt(void) {
+
+#if NIL_DBG_ENABLED
+  fprintf(stderr, "halt: %s\n", nil.dbg_msg ? nil.dbg_msg : "");
+#else
+  fprintf(stderr, "halt\n");
+#endif
+  abort();
+}
+
+/**
+ * @brief   Time stamp with @p PORT_TIME_STAMP_CYCLES resolution.
+ * @details Virtual time does not advance while threads run so the time
+ *          stamp only changes at ticks.
+ *
+ * @return              The time stamp.
+ */
+uint16_t port_time_stamp(void) {
+
+#if NIL_CFG_TIMEDELTA == 0
+  return (uint16_t)(port_sim_counter << 8);
+#else
+  return (uint16_t)port_sim_counter;
+#endif
+}
+
+/**
+ * @brief   Time with @p PORT_TIME_STAMP_CYCLES resolution.
+ * @details The 32-bit version of @p port_time_stamp().
+ *
+ * @return              The time.
+ */
+uint32_t port_time_hires(void) {
+
+#if NIL_CFG_TIMEDELTA == 0
+  return port_sim_counter << 8;
+#else
+  return port_sim_counter;
+#endif
+}
+
+/**
+ * @brief   Advances virtual time by one tick or timer count.
+ * @details Runs the system timer ISR code when it is due, like the AVR
+ *          Timer0 compare ISR in tick mode or the Timer1 alarm ISR in
+ *          tick-less mode.  Called from the idle thread, or from another
+ *          thread to model that thread running for a tick.
+ * @note    If @p port_sim_tick_hook is set it is called first, in the
+ *          same ISR context, to model a device ISR like an ADC ISR.
+ */
+void port_sim_tick(void) {
+
+  /* Interrupts are disabled in an ISR.*/
+  port_lock();
+  port_sim_counter++;
+#if NIL_CFG_TIMEDELTA > 0
+  if (!port_sim_tick_hook && (!port_sim_alarm_on ||
+      ((systime_t)port_sim_counter != port_sim_alarm))) {
+    port_unlock();
+    return;
+  }
+#endif
+  NIL_IRQ_PROLOGUE();
+  if (port_sim_tick_hook)
+    port_sim_tick_hook();
+#if NIL_CFG_TIMEDELTA > 0
+  if (port_sim_alarm_on && ((systime_t)port_sim_counter == port_sim_alarm))
+#endif
+    nilSysTimerHandlerI();
+  NIL_IRQ_EPILOGUE();
+  port_unlock();
+}
+
+/**
+ * @brief   Advances virtual time.
+ *
+ * @param[in] ticks     number of ticks or timer counts
+ */
+void port_sim_run(uint32_t ticks) {
+
+  while (ticks--)
+    port_sim_tick();
+}
+
+/**
+ * @brief   Returns the virtual time.
+ *
+ * @return              Ticks in tick mode else timer counts, since the
+ *                      start of the program.
+ */
+uint32_t port_sim_now(void) {
+
+  return port_sim_counter;
+}
+
+/**
+ * @brief   Starts Nil RTOS.
+ * @details Host version of the function in NilRTOS.c.  The caller becomes
+ *          the idle thread.
+ *
+ * @return TRUE, thread table errors are compile errors.
+ */
+bool nilSysBegin(void) {
+
+  /* The thread count is checked at compile time by NIL_THREADS_TABLE_END().*/
+  nilSysLock();
+  nilSysInit();
+  return TRUE;
+}
+
+/**
+ * @brief   Returns the semaphore counter current value.
+ * @details Host version of the function in NilRTOS.c, which needs the
+ *          AVR heap, for NilFIFO.h.
+ *
+ * @param[in] sp        pointer to a @p semaphore_t structure
+ * @return              The value of the semaphore counter.
+ *
+ * @api
+ */
+cnt_t nilSemGetCounter(semaphore_t *sp) {
+  cnt_t cnt;
+
+  nilSysLock();
+  cnt = sp->cnt;
+  nilSysUnlock();
+  return cnt;
+}
+
+/** @} */
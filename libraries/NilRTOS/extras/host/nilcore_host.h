@@ -0,0 +1,263 @@
+/*
+    Nil RTOS - Copyright (C) 2012 Giovanni Di Sirio.
+
+    This file is part of Nil RTOS.
+
+    Nil RTOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    Nil RTOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    nilcore_host.h
+ * @brief   Linux host port macros and structures.
+ * @details Threads are ucontext coroutines and time is a virtual clock
+ *          advanced by @p port_sim_tick() so runs are deterministic.
+ *          Selected with @p NIL_PORT_HEADER, see the Makefile.
+ *
+ * @addtogroup HOST_CORE
+ * @{
+ */
+
+#ifndef _NILCORE_H_
+#define _NILCORE_H_
+
+#include <ucontext.h>
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Stack size for the host C library and signal handlers.
+ * @details The working area size passed to @p NIL_WORKING_AREA() is added
+ *          to this size so AVR sketch sizes can be used unchanged.
+ */
+#if !defined(PORT_INT_REQUIRED_STACK) || defined(__DOXYGEN__)
+#define PORT_INT_REQUIRED_STACK         16384
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if NIL_CFG_TIMEDELTA > 0
+/**
+ * @brief   CPU cycles per count of the simulated timer.
+ */
+#define PORT_TIMER_PRESCALE             (F_CPU / NIL_CFG_FREQUENCY)
+#endif
+
+/**
+ * @brief   CPU cycles per count of @p port_time_stamp() and
+ *          @p port_time_hires().
+ */
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+#define PORT_TIME_STAMP_CYCLES          (F_CPU / NIL_CFG_FREQUENCY / 256)
+#else
+#define PORT_TIME_STAMP_CYCLES          PORT_TIMER_PRESCALE
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Type of stack and memory alignment enforcement.
+ */
+typedef uint64_t stkalign_t;
+
+/**
+ * @brief   Interrupt saved context.
+ * @note    Not used, interrupts are simulated with function calls.
+ */
+struct port_extctx {
+  uint8_t       dummy;
+};
+
+/**
+ * @brief   System saved context.
+ * @details The context is at the top of the thread working area like the
+ *          AVR port, the rest of the working area is the thread stack.
+ */
+struct port_intctx {
+  ucontext_t    uc;
+  tfunc_t       pf;
+  void          *arg;
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Platform dependent context creation for new threads.
+ */
+#define SETUP_CONTEXT(tp, workspace, wsize, pf, arg)                        \
+  _port_setup_context(tp, workspace, wsize, pf, arg)
+
+/**
+ * @brief   Enforces a correct alignment for a stack area size value.
+ */
+#define STACK_ALIGN(n) ((((n) - 1) | (sizeof(stkalign_t) - 1)) + 1)
+
+/**
+ * @brief   Computes the thread working area global size.
+ */
+#define THD_WA_SIZE(n) STACK_ALIGN(sizeof(struct port_intctx) +             \
+                                   PORT_INT_REQUIRED_STACK + (n) +          \
+                                   NIL_STACK_GUARD_SIZE)
+
+/**
+ * @brief   Static working area allocation.
+ */
+#define NIL_WORKING_AREA(s, n)                                              \
+  stkalign_t s[THD_WA_SIZE(n) / sizeof(stkalign_t)]
+
+/**
+ * @brief   Thread declaration macro optimized for the host.
+ */
+#define PORT_THREAD(tname, arg) void tname(void *arg)
+
+/**
+ * @brief   IRQ prologue code.
+ */
+#define PORT_IRQ_PROLOGUE()
+
+/**
+ * @brief   IRQ epilogue code.
+ */
+#define PORT_IRQ_EPILOGUE() {                                               \
+  nilSysLockFromISR();                                                      \
+  nilSchRescheduleS();                                                      \
+  nilSysUnlockFromISR();                                                    \
+}
+
+/**
+ * @brief   IRQ handler function declaration.
+ */
+#define PORT_IRQ_HANDLER(id) void id(void)
+
+/**
+ * @brief   Port-related initialization code.
+ */
+#define port_init()
+
+/**
+ * @brief   Kernel-lock action.
+ * @details The lock is a counter so misuse is detected at switch time.
+ */
+#define port_lock() (port_lock_count++)
+
+/**
+ * @brief   Kernel-unlock action.
+ */
+#define port_unlock() (port_lock_count--)
+
+/**
+ * @brief   Kernel-lock action from an interrupt handler.
+ * @details Simulated interrupts already run with the kernel locked.
+ */
+#define port_lock_from_isr()
+
+/**
+ * @brief   Kernel-unlock action from an interrupt handler.
+ */
+#define port_unlock_from_isr()
+
+/**
+ * @brief   Disables all the interrupt sources.
+ */
+#define port_disable()
+
+/**
+ * @brief   Disables the interrupt sources below kernel-level priority.
+ */
+#define port_suspend()
+
+/**
+ * @brief   Enables all the interrupt sources.
+ */
+#define port_enable() (port_lock_count = 0)
+
+/**
+ * @brief   Enters an architecture-dependent IRQ-waiting mode.
+ */
+#define port_wait_for_interrupt()
+
+#if NIL_CFG_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the current value of the simulated timer counter.
+ */
+#define port_timer_get_time() ((systime_t)port_sim_counter)
+
+/**
+ * @brief   Starts the alarm.
+ */
+#define port_timer_set_alarm(time) {                                        \
+  port_sim_alarm = (time);                                                  \
+  port_sim_alarm_on = true;                                                 \
+}
+
+/**
+ * @brief   Stops the alarm interrupt.
+ */
+#define port_timer_reset_alarm() {port_sim_alarm_on = false;}
+
+/**
+ * @brief   Returns the current alarm time.
+ */
+#define port_timer_get_alarm() (port_sim_alarm)
+#endif /* NIL_CFG_TIMEDELTA > 0 */
+
+/**
+ * @brief   Performs a context switch between two threads.
+ *
+ * @param[in] ntp       the thread to be switched in
+ * @param[in] otp       the thread to be switched out
+ */
+#define port_switch(ntp, otp) _port_switch(ntp, otp)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  extern int port_lock_count;
+  extern uint32_t port_sim_counter;
+  extern systime_t port_sim_alarm;
+  extern bool port_sim_alarm_on;
+  extern void (*port_sim_tick_hook)(void);
+  void _port_setup_context(thread_t *tp, void *wsp, size_t size,
+                           tfunc_t pf, void *arg);
+  void _port_switch(thread_t *ntp, thread_t *otp);
+  void port_halt(void);
+  uint16_t port_time_stamp(void);
+  uint32_t port_time_hires(void);
+  void port_sim_tick(void);
+  void port_sim_run(uint32_t ticks);
+  uint32_t port_sim_now(void);
+  bool nilSysBegin(void);
+  cnt_t nilSemGetCounter(semaphore_t *sp);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NILCORE_H_ */
+
+/** @} */
@@ -0,0 +1,89 @@
+/**
+ * @file    hostTest.h
+ * @brief   Helpers for the host port regression tests.
+ * @details Each test is a program with its own thread table.  Threads
+ *          append numbers to a log, main() runs the virtual clock and
+ *          compares the log with the expected order.
+ */
+#ifndef hostTest_h
+#define hostTest_h
+#include <stdio.h>
+#include <stdlib.h>
+#include "NilRTOS.h"
+
+/** Abort the test with a message if @p cond is false. */
+#define TEST_ASSERT(cond) do {                                              \
+  if (!(cond)) {                                                            \
+    fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #cond);       \
+    exit(1);                                                                \
+  }                                                                         \
+} while (0)
+
+/** Log size. */
+#define TEST_LOG_SIZE 64
+
+static int testLog[TEST_LOG_SIZE];
+static int testLogCount;
+
+/** Append @p n to the log. */
+#define TEST_LOG(n) do {                                                    \
+  TEST_ASSERT(testLogCount < TEST_LOG_SIZE);                                \
+  testLog[testLogCount++] = (n);                                            \
+} while (0)
+
+/** Minimum timeout, timeouts are rounded up to TIMEDELTA in tick-less mode. */
+#define TEST_TIMEOUT(n) ((n) < NIL_CFG_TIMEDELTA ? NIL_CFG_TIMEDELTA : (n))
+
+/** Ticks in tick mode or timer counts in tick-less mode. */
+#if NIL_CFG_TIMEDELTA == 0
+#define TEST_TIME(ticks) (ticks)
+#else
+/* Tick-less tests use 1024 usec ticks like the default tick mode.*/
+#define TEST_TIME(ticks) ((ticks) * 256)
+#endif
+
+/** Block the calling thread forever. */
+#define TEST_THREAD_END() do {                                              \
+  nilThdSleep(TIME_INFINITE);                                               \
+  TEST_ASSERT(0);                                                           \
+} while (0)
+
+/**
+ * Thread table and main() for a test of an option that is disabled in
+ * the configuration.  Put the test in an @p #if block and this in the
+ * @p #else part.
+ *
+ * @param[in] name  test name
+ * @param[in] msg   reason the test is not run
+ */
+#define TEST_DISABLED(name, msg)                                            \
+NIL_WORKING_AREA(waDisabled, 0);                                            \
+NIL_THREAD(Disabled, arg) {                                                 \
+  (void)arg;                                                                \
+  TEST_THREAD_END();                                                        \
+}                                                                           \
+NIL_THREADS_TABLE_BEGIN()                                                   \
+NIL_THREADS_TABLE_ENTRY("disabled", Disabled, NULL, waDisabled,             \
+                        sizeof(waDisabled))                                 \
+NIL_THREADS_TABLE_END()                                                     \
+int main(void) {                                                            \
+  printf("%s: %s\n", name, msg);                                            \
+  return 0;                                                                 \
+}
+
+/**
+ * Print the log and check it against @p want.
+ *
+ * @param[in] name  test name
+ * @param[in] want  expected log
+ * @param[in] n     number of expected entries
+ */
+static inline void testCheckLog(const char* name, const int* want, int n) {
+  int i;
+  printf("%s:", name);
+  for (i = 0; i < testLogCount; i++) printf(" %d", testLog[i]);
+  printf("\n");
+  TEST_ASSERT(testLogCount == n);
+  for (i = 0; i < n; i++) TEST_ASSERT(testLog[i] == want[i]);
+}
+#endif  // hostTest_h
@@ -0,0 +1,66 @@
+/* CPU usage split between a busy thread, a waiting thread and idle. */
+#include "hostTest.h"
+
+#if NIL_CFG_CPU_USAGE
+static SEMAPHORE_DECL(never, 0);
+
+NIL_WORKING_AREA(waBusy, 0);
+NIL_THREAD(Busy, arg) {
+  (void)arg;
+  for (;;) {
+    /* Run for three ticks then let idle run for one.*/
+    port_sim_run(TEST_TIME(3));
+    nilThdSleep(TEST_TIME(1));
+  }
+}
+
+NIL_WORKING_AREA(waWaiter, 0);
+NIL_THREAD(Waiter, arg) {
+  (void)arg;
+  nilSemWait(&never);
+  TEST_ASSERT(0);
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("busy", Busy, NULL, waBusy, sizeof(waBusy))
+NIL_THREADS_TABLE_ENTRY("waiter", Waiter, NULL, waWaiter, sizeof(waWaiter))
+NIL_THREADS_TABLE_END()
+
+static void snapshot(void) {
+  nilSysLock();
+  nilCpuUsageSnapshotS();
+  nilSysUnlock();
+}
+
+int main(void) {
+  uint32_t total;
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(4));
+  /* Restart the measurement after the threads start.*/
+  snapshot();
+  port_sim_run(TEST_TIME(100));
+  snapshot();
+  total = nil.threads[0].cpusnap + nil.threads[1].cpusnap +
+          nil.threads[2].cpusnap;
+  printf("testCpuUsage: busy %u waiter %u idle %u\n",
+         nil.threads[0].cpusnap, nil.threads[1].cpusnap,
+         nil.threads[2].cpusnap);
+  TEST_ASSERT(total > 0);
+  TEST_ASSERT(nil.threads[1].cpusnap == 0);
+  TEST_ASSERT(nil.threads[0].cpusnap == 3 * nil.threads[2].cpusnap);
+
+  /* A longer period is scaled more with the same split.*/
+  port_sim_run(TEST_TIME(1000));
+  snapshot();
+  printf("testCpuUsage: busy %u waiter %u idle %u\n",
+         nil.threads[0].cpusnap, nil.threads[1].cpusnap,
+         nil.threads[2].cpusnap);
+  total = nil.threads[0].cpusnap + nil.threads[2].cpusnap;
+  TEST_ASSERT(total > 0X7FFF && total <= 0XFFFF);
+  TEST_ASSERT(nil.threads[1].cpusnap == 0);
+  TEST_ASSERT(nil.threads[0].cpusnap == 3 * nil.threads[2].cpusnap);
+  return 0;
+}
+#else  /* NIL_CFG_CPU_USAGE */
+TEST_DISABLED("testCpuUsage", "CPU usage disabled")
+#endif  /* NIL_CFG_CPU_USAGE */
@@ -0,0 +1,65 @@
+/* Event flags wait any, wait all and priority order of waiters. */
+#include "hostTest.h"
+
+#if NIL_CFG_USE_EVENTS
+static EVENT_FLAGS_DECL(ev);
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  (void)arg;
+  TEST_ASSERT(nilEvtWaitAnyTimeout(&ev, 3, TEST_TIME(2)) == 0);
+  TEST_LOG(10);
+  TEST_ASSERT(nilEvtWaitAny(&ev, 3) == 2);
+  TEST_LOG(11);
+  TEST_ASSERT(nilEvtWaitAll(&ev, 5) == 5);
+  TEST_LOG(12);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread2, 0);
+NIL_THREAD(Thread2, arg) {
+  (void)arg;
+  TEST_ASSERT(nilEvtWaitAny(&ev, 6) == 4);
+  TEST_LOG(20);
+  TEST_ASSERT(nilEvtWaitAnyTimeout(&ev, 8, TIME_IMMEDIATE) == 0);
+  TEST_LOG(21);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread3, 0);
+NIL_THREAD(Thread3, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(5));
+  /* Thread1 takes 2.*/
+  nilEvtSignal(&ev, 2);
+  TEST_LOG(30);
+  /* Thread1 waits for all of 5.*/
+  nilEvtSignal(&ev, 1);
+  TEST_LOG(31);
+  /* Thread1 takes 5, nothing left for Thread2.*/
+  nilEvtSignal(&ev, 4);
+  TEST_LOG(32);
+  TEST_ASSERT(ev.waiters == 2);
+  /* Thread2 takes 4.*/
+  nilEvtSignal(&ev, 4);
+  TEST_LOG(33);
+  TEST_ASSERT(ev.flags == 0 && ev.waiters == 0);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("thread2", Thread2, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_ENTRY("thread3", Thread3, NULL, waThread3, sizeof(waThread3))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {10, 11, 30, 31, 12, 32, 20, 21, 33};
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(20));
+  testCheckLog("testEvents", want, sizeof(want)/sizeof(want[0]));
+  return 0;
+}
+#else  /* NIL_CFG_USE_EVENTS */
+TEST_DISABLED("testEvents", "event flags disabled")
+#endif  /* NIL_CFG_USE_EVENTS */
@@ -0,0 +1,81 @@
+// NilFIFO and NilStatsFIFO order, timeouts and statistics.
+#include "hostTest.h"
+#include "NilFIFO.h"
+
+static NilFIFO<int, 4> fifo;
+static NilStatsFIFO<int, 2> statsFifo;
+#if NIL_CFG_FIFO_LATENCY
+static NilStatsFIFO<int, 2> slowFifo;
+#endif  // NIL_CFG_FIFO_LATENCY
+static int nextData;
+static int nextStats;
+
+NIL_WORKING_AREA(waConsumer, 0);
+NIL_THREAD(Consumer, arg) {
+  (void)arg;
+  TEST_ASSERT(fifo.waitData(TIME_IMMEDIATE) == 0);
+  for (;;) {
+    int* p = fifo.waitData(TIME_INFINITE);
+    TEST_ASSERT(p && *p == nextData++);
+    fifo.signalFree();
+    p = statsFifo.waitData(TIME_INFINITE);
+    TEST_ASSERT(p && *p == nextStats++);
+    statsFifo.signalFree();
+    // Slow consumer to fill the FIFOs.
+    if ((nextData % 16) == 0) nilThdSleep(2);
+  }
+}
+
+NIL_WORKING_AREA(waProducer, 0);
+NIL_THREAD(Producer, arg) {
+  int i = 0;
+  int overruns = 0;
+  (void)arg;
+  for (;;) {
+    int* p = fifo.waitFree(TIME_INFINITE);
+    *p = i;
+    fifo.signalData();
+    // Never block on the stats FIFO, count overruns.
+    while ((p = statsFifo.waitFree(TIME_IMMEDIATE)) == 0) {
+      overruns++;
+      nilThdSleep(1);
+    }
+    *p = i++;
+    statsFifo.signalData();
+    if (i == 1000) break;
+  }
+  TEST_ASSERT(overruns > 0);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("consumer", Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_ENTRY("producer", Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_END()
+
+int main() {
+  Print pr;
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(1000);
+  TEST_ASSERT(nextData == 1000 && nextStats == 1000);
+  TEST_ASSERT(fifo.freeCount() == 4);
+  TEST_ASSERT(statsFifo.minimumFreeCount() == 0);
+  TEST_ASSERT(statsFifo.maxOverrunCount() > 0);
+#if NIL_CFG_FIFO_LATENCY
+  // Records wait up to two ticks while the consumer sleeps.
+  TEST_ASSERT(statsFifo.latencyPercentile(100) > 0);
+  TEST_ASSERT(statsFifo.latencyPercentile(50) <=
+              statsFifo.latencyPercentile(100));
+
+  // A wait longer than the 16-bit stamp range is saturated, not wrapped.
+  TEST_ASSERT(slowFifo.waitFree(TIME_IMMEDIATE) != 0);
+  slowFifo.signalData();
+  port_sim_run(TEST_TIME(300));
+  TEST_ASSERT(slowFifo.waitData(TIME_IMMEDIATE) != 0);
+  slowFifo.signalFree();
+  TEST_ASSERT(slowFifo.latencyPercentile(100) == HR2US(0XFFFF));
+#endif  // NIL_CFG_FIFO_LATENCY
+  printf("testFifo:\n");
+  statsFifo.printStats(&pr);
+  return 0;
+}
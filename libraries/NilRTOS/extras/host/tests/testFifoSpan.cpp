@@ -0,0 +1,78 @@
+// NilFIFO and NilStatsFIFO span order, wrap and counts.
+#include "hostTest.h"
+#include "NilFIFO.h"
+
+static NilFIFO<int, 8> fifo;
+static NilStatsFIFO<int, 5> statsFifo;
+static int nextData;
+static int nextStats;
+static int dataSpans;
+
+NIL_WORKING_AREA(waConsumer, 0);
+NIL_THREAD(Consumer, arg) {
+  size_t n;
+  (void)arg;
+  TEST_ASSERT(fifo.waitDataSpan(4, TIME_IMMEDIATE, &n) == 0 && n == 0);
+  // A zero count returns without taking a record.
+  TEST_ASSERT(fifo.waitFreeSpan(0, TIME_INFINITE, &n) == 0 && n == 0);
+  TEST_ASSERT(fifo.freeCount() == 8);
+  TEST_ASSERT(statsFifo.waitFreeSpan(0, TIME_INFINITE, &n) == 0 && n == 0);
+  TEST_ASSERT(statsFifo.freeCount() == 5 && statsFifo.overrunCount() == 0);
+  for (;;) {
+    TEST_ASSERT(fifo.waitDataSpan(0, TIME_INFINITE, &n) == 0 && n == 0);
+    TEST_ASSERT(statsFifo.waitDataSpan(0, TIME_INFINITE, &n) == 0 && n == 0);
+    int* p = fifo.waitDataSpan(8, TIME_INFINITE, &n);
+    TEST_ASSERT(p && n >= 1 && n <= 8);
+    dataSpans++;
+    for (size_t i = 0; i < n; i++) TEST_ASSERT(p[i] == nextData++);
+    fifo.signalFree(n);
+    // Take the stats FIFO records one at a time and in spans of two.
+    p = statsFifo.waitDataSpan(nextStats & 1 ? 1 : 2, TIME_INFINITE, &n);
+    TEST_ASSERT(p && n >= 1 && n <= 2);
+    for (size_t i = 0; i < n; i++) TEST_ASSERT(p[i] == nextStats++);
+    statsFifo.signalFree(n);
+    // Slow consumer to fill the FIFOs.
+    nilThdSleep(1);
+  }
+}
+
+NIL_WORKING_AREA(waProducer, 0);
+NIL_THREAD(Producer, arg) {
+  int i = 0;
+  int j = 0;
+  size_t n;
+  (void)arg;
+  while (i < 1000) {
+    int* p = fifo.waitFreeSpan(3, TIME_INFINITE, &n);
+    TEST_ASSERT(p && n >= 1 && n <= 3);
+    for (size_t k = 0; k < n; k++) p[k] = i++;
+    fifo.signalData(n);
+    // Never block on the stats FIFO.
+    p = statsFifo.waitFreeSpan(4, TIME_IMMEDIATE, &n);
+    if (!p) {
+      TEST_ASSERT(n == 0 && statsFifo.overrunCount());
+      continue;
+    }
+    for (size_t k = 0; k < n; k++) p[k] = j++;
+    statsFifo.signalData(n);
+  }
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("consumer", Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_ENTRY("producer", Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_END()
+
+int main() {
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(1000));
+  TEST_ASSERT(nextData == 1000);
+  // The consumer waits on the data semaphore so its count is -1.
+  TEST_ASSERT(fifo.freeCount() == 8 && fifo.dataCount() == (size_t)-1);
+  TEST_ASSERT(statsFifo.maxOverrunCount() > 0);
+  // Several records per semaphore wait.
+  TEST_ASSERT(dataSpans < nextData/2);
+  printf("testFifoSpan: %d records in %d spans\n", nextData, dataSpans);
+  return 0;
+}
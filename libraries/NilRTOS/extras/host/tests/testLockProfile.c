@@ -0,0 +1,64 @@
+/* Lock profile records the longest lock section and its lock address. */
+#include "hostTest.h"
+
+/* Simulated time the long lock section is held.*/
+#define HOLD_COUNT 3
+
+#if NIL_CFG_LOCK_PROFILE
+/* Time stamp counts per simulated counter step.*/
+#if NIL_CFG_TIMEDELTA == 0
+#define STAMP_STEP 256
+#else
+#define STAMP_STEP 1
+#endif
+
+static __attribute__((noinline)) void longLock(void) {
+  nilSysLock();
+  /* Time passes with interrupts disabled.*/
+  port_sim_counter += HOLD_COUNT;
+  nilSysUnlock();
+}
+#endif  /* NIL_CFG_LOCK_PROFILE */
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(2));
+#if NIL_CFG_LOCK_PROFILE
+  longLock();
+#endif  /* NIL_CFG_LOCK_PROFILE */
+  nilThdSleep(TEST_TIME(2));
+  TEST_LOG(1);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {1};
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(10));
+  testCheckLog("testLockProfile", want, sizeof(want)/sizeof(want[0]));
+#if NIL_CFG_LOCK_PROFILE
+  {
+    uint16_t d = HOLD_COUNT*STAMP_STEP;
+    int bin = 0;
+    char *site = (char *)nil.lockprof.maxsite;
+
+    while (d && bin < NIL_CFG_LOCK_PROFILE_BINS - 1) {
+      d >>= 1;
+      bin++;
+    }
+    TEST_ASSERT(nil.lockprof.max == HOLD_COUNT*STAMP_STEP);
+    TEST_ASSERT(site > (char *)longLock && site < (char *)longLock + 256);
+    TEST_ASSERT(nil.lockprof.hist[bin] == 1);
+    /* Other sections do not span a simulated tick.*/
+    TEST_ASSERT(nil.lockprof.hist[0] > 0);
+  }
+#else  /* NIL_CFG_LOCK_PROFILE */
+  printf("testLockProfile: lock profile disabled\n");
+#endif  /* NIL_CFG_LOCK_PROFILE */
+  return 0;
+}
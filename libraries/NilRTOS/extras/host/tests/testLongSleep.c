@@ -0,0 +1,45 @@
+/* Long and short timeouts, across the systime_t wrap in tick-less mode. */
+#include "hostTest.h"
+
+static SEMAPHORE_DECL(sem, 0);
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  (void)arg;
+  nilThdSleep(100);
+  TEST_ASSERT(port_sim_now() == 100);
+  TEST_ASSERT(nilSemWaitTimeout(&sem, 50) == NIL_MSG_TMO);
+  TEST_ASSERT(port_sim_now() == 150);
+  nilThdSleep(45000);
+  TEST_ASSERT(port_sim_now() == 45150);
+  nilThdSleep(30000);
+  TEST_ASSERT(port_sim_now() == 75150);
+  TEST_LOG(10);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread2, 0);
+NIL_THREAD(Thread2, arg) {
+  (void)arg;
+  nilThdSleep(120);
+  TEST_ASSERT(port_sim_now() == 120);
+  nilThdSleep(3);
+  TEST_ASSERT(port_sim_now() == 120 + TEST_TIMEOUT(3));
+  nilThdSleepUntil(1000);
+  TEST_ASSERT(port_sim_now() == 1000);
+  TEST_LOG(20);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("thread2", Thread2, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {20, 10};
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(200000);
+  testCheckLog("testLongSleep", want, sizeof(want)/sizeof(want[0]));
+  return 0;
+}
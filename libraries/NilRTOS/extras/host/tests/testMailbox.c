@@ -0,0 +1,57 @@
+/* Mailbox post, post ahead, fetch, timeouts and reset. */
+#include "hostTest.h"
+
+static msg_t mbBuf[3];
+static MAILBOX_DECL(mb, mbBuf, 3);
+
+NIL_WORKING_AREA(waConsumer, 0);
+NIL_THREAD(Consumer, arg) {
+  msg_t msg;
+  (void)arg;
+  TEST_ASSERT(nilMBFetchTimeout(&mb, &msg, TEST_TIME(2)) == NIL_MSG_TMO);
+  TEST_LOG(-1);
+  for (;;) {
+    if (nilMBFetch(&mb, &msg) == NIL_MSG_RST) {
+      TEST_LOG(-2);
+      break;
+    }
+    TEST_LOG(msg);
+    if (msg == 3) nilThdSleep(TEST_TIME(5));
+  }
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waProducer, 0);
+NIL_THREAD(Producer, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(3));
+  TEST_ASSERT(nilMBPost(&mb, 1) == NIL_MSG_OK);
+  TEST_ASSERT(nilMBPost(&mb, 2) == NIL_MSG_OK);
+  /* The consumer sleeps after 3.*/
+  TEST_ASSERT(nilMBPost(&mb, 3) == NIL_MSG_OK);
+  TEST_ASSERT(nilMBPost(&mb, 4) == NIL_MSG_OK);
+  TEST_ASSERT(nilMBPost(&mb, 5) == NIL_MSG_OK);
+  nilSysLock();
+  TEST_ASSERT(nilMBPostAheadI(&mb, 9) == NIL_MSG_OK);
+  TEST_ASSERT(nilMBPostI(&mb, 6) == NIL_MSG_TMO);
+  nilSysUnlock();
+  TEST_ASSERT(nilMBPostTimeout(&mb, 6, TEST_TIME(1)) == NIL_MSG_TMO);
+  /* Waits for the consumer.*/
+  TEST_ASSERT(nilMBPost(&mb, 7) == NIL_MSG_OK);
+  nilThdSleep(TEST_TIME(2));
+  nilMBReset(&mb);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("consumer", Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_ENTRY("producer", Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {-1, 1, 2, 3, 9, 4, 5, 7, -2};
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(30));
+  testCheckLog("testMailbox", want, sizeof(want)/sizeof(want[0]));
+  return 0;
+}
@@ -0,0 +1,80 @@
+/* More threads than bits in a thread mask, semaphore wake order. */
+#include "hostTest.h"
+
+#if !NIL_USE_THD_MASK
+#define NUM_WAITERS 19
+
+static SEMAPHORE_DECL(sem, 0);
+static int next;
+
+NIL_THREAD(Waiter, arg) {
+  TEST_ASSERT(nilSemWait(&sem) == NIL_MSG_OK);
+  /* Waiters are released in priority order.*/
+  TEST_ASSERT((int)(size_t)arg == next++);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waSignal, 0);
+NIL_THREAD(Signal, arg) {
+  int i;
+  (void)arg;
+  nilThdSleep(TEST_TIME(2));
+  TEST_ASSERT(sem.cnt == -NUM_WAITERS);
+  for (i = 0; i < NUM_WAITERS; i++) nilSemSignal(&sem);
+  TEST_ASSERT(sem.cnt == 0);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(wa0, 0);
+NIL_WORKING_AREA(wa1, 0);
+NIL_WORKING_AREA(wa2, 0);
+NIL_WORKING_AREA(wa3, 0);
+NIL_WORKING_AREA(wa4, 0);
+NIL_WORKING_AREA(wa5, 0);
+NIL_WORKING_AREA(wa6, 0);
+NIL_WORKING_AREA(wa7, 0);
+NIL_WORKING_AREA(wa8, 0);
+NIL_WORKING_AREA(wa9, 0);
+NIL_WORKING_AREA(wa10, 0);
+NIL_WORKING_AREA(wa11, 0);
+NIL_WORKING_AREA(wa12, 0);
+NIL_WORKING_AREA(wa13, 0);
+NIL_WORKING_AREA(wa14, 0);
+NIL_WORKING_AREA(wa15, 0);
+NIL_WORKING_AREA(wa16, 0);
+NIL_WORKING_AREA(wa17, 0);
+NIL_WORKING_AREA(wa18, 0);
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("waiter0", Waiter, (void*)0, wa0, sizeof(wa0))
+NIL_THREADS_TABLE_ENTRY("waiter1", Waiter, (void*)1, wa1, sizeof(wa1))
+NIL_THREADS_TABLE_ENTRY("waiter2", Waiter, (void*)2, wa2, sizeof(wa2))
+NIL_THREADS_TABLE_ENTRY("waiter3", Waiter, (void*)3, wa3, sizeof(wa3))
+NIL_THREADS_TABLE_ENTRY("waiter4", Waiter, (void*)4, wa4, sizeof(wa4))
+NIL_THREADS_TABLE_ENTRY("waiter5", Waiter, (void*)5, wa5, sizeof(wa5))
+NIL_THREADS_TABLE_ENTRY("waiter6", Waiter, (void*)6, wa6, sizeof(wa6))
+NIL_THREADS_TABLE_ENTRY("waiter7", Waiter, (void*)7, wa7, sizeof(wa7))
+NIL_THREADS_TABLE_ENTRY("waiter8", Waiter, (void*)8, wa8, sizeof(wa8))
+NIL_THREADS_TABLE_ENTRY("waiter9", Waiter, (void*)9, wa9, sizeof(wa9))
+NIL_THREADS_TABLE_ENTRY("waiter10", Waiter, (void*)10, wa10, sizeof(wa10))
+NIL_THREADS_TABLE_ENTRY("waiter11", Waiter, (void*)11, wa11, sizeof(wa11))
+NIL_THREADS_TABLE_ENTRY("waiter12", Waiter, (void*)12, wa12, sizeof(wa12))
+NIL_THREADS_TABLE_ENTRY("waiter13", Waiter, (void*)13, wa13, sizeof(wa13))
+NIL_THREADS_TABLE_ENTRY("waiter14", Waiter, (void*)14, wa14, sizeof(wa14))
+NIL_THREADS_TABLE_ENTRY("waiter15", Waiter, (void*)15, wa15, sizeof(wa15))
+NIL_THREADS_TABLE_ENTRY("waiter16", Waiter, (void*)16, wa16, sizeof(wa16))
+NIL_THREADS_TABLE_ENTRY("waiter17", Waiter, (void*)17, wa17, sizeof(wa17))
+NIL_THREADS_TABLE_ENTRY("waiter18", Waiter, (void*)18, wa18, sizeof(wa18))
+NIL_THREADS_TABLE_ENTRY("signal", Signal, NULL, waSignal, sizeof(waSignal))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(5));
+  TEST_ASSERT(next == NUM_WAITERS);
+  printf("testManyThreads: %d threads\n", nil_thd_count);
+  return 0;
+}
+#else  /* !NIL_USE_THD_MASK */
+TEST_DISABLED("testManyThreads", "thread masks enabled")
+#endif  /* !NIL_USE_THD_MASK */
@@ -0,0 +1,89 @@
+// NilMpmcFIFO stress, no lost or duplicated records and priority wakeup.
+#include <string.h>
+#include "hostTest.h"
+#include "NilFIFO.h"
+
+#define NUM_PRODUCERS 3
+#define NUM_CONSUMERS 2
+#define NUM_RECORDS 2000
+
+struct Record {
+  int producer;
+  int seq;
+};
+
+static NilMpmcFIFO<Record, 5> fifo;
+static bool received[NUM_PRODUCERS][NUM_RECORDS];
+static int receivedCount;
+static int firstConsumer = -1;
+static unsigned seed = 11;
+
+static unsigned rnd(void) {
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0X7FFF;
+}
+
+NIL_THREAD(Consumer, arg) {
+  int id = (int)(size_t)arg;
+  int last[NUM_PRODUCERS];
+  for (int i = 0; i < NUM_PRODUCERS; i++) last[i] = -1;
+  for (;;) {
+    Record* p = fifo.waitData(TIME_INFINITE);
+    TEST_ASSERT(p);
+    if (firstConsumer < 0) firstConsumer = id;
+    // Hold the record while other threads run.
+    if (rnd() % 8 == 0) nilThdSleep(1);
+    TEST_ASSERT(p->producer >= 0 && p->producer < NUM_PRODUCERS);
+    TEST_ASSERT(p->seq >= 0 && p->seq < NUM_RECORDS);
+    // A consumer takes each producer's records in order.
+    TEST_ASSERT(p->seq > last[p->producer]);
+    last[p->producer] = p->seq;
+    TEST_ASSERT(!received[p->producer][p->seq]);
+    received[p->producer][p->seq] = true;
+    receivedCount++;
+    memset(p, 0XFF, sizeof(Record));
+    fifo.signalFree(p);
+  }
+}
+
+NIL_THREAD(Producer, arg) {
+  int id = (int)(size_t)arg;
+  for (int seq = 0; seq < NUM_RECORDS; seq++) {
+    Record* p = fifo.waitFree(TIME_INFINITE);
+    TEST_ASSERT(p);
+    p->producer = id;
+    // Hold the record so later records are written first.
+    if (rnd() % 8 == 0) nilThdSleep(1);
+    p->seq = seq;
+    fifo.signalData(p);
+  }
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waConsumer0, 0);
+NIL_WORKING_AREA(waConsumer1, 0);
+NIL_WORKING_AREA(waProducer0, 0);
+NIL_WORKING_AREA(waProducer1, 0);
+NIL_WORKING_AREA(waProducer2, 0);
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("consumer0", Consumer, (void*)0, waConsumer0, sizeof(waConsumer0))
+NIL_THREADS_TABLE_ENTRY("consumer1", Consumer, (void*)1, waConsumer1, sizeof(waConsumer1))
+NIL_THREADS_TABLE_ENTRY("producer0", Producer, (void*)0, waProducer0, sizeof(waProducer0))
+NIL_THREADS_TABLE_ENTRY("producer1", Producer, (void*)1, waProducer1, sizeof(waProducer1))
+NIL_THREADS_TABLE_ENTRY("producer2", Producer, (void*)2, waProducer2, sizeof(waProducer2))
+NIL_THREADS_TABLE_END()
+
+int main() {
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(5000));
+  // Both consumers waited, the higher priority consumer got the first record.
+  TEST_ASSERT(firstConsumer == 0);
+  TEST_ASSERT(receivedCount == NUM_PRODUCERS*NUM_RECORDS);
+  for (int i = 0; i < NUM_PRODUCERS; i++) {
+    for (int j = 0; j < NUM_RECORDS; j++) TEST_ASSERT(received[i][j]);
+  }
+  TEST_ASSERT(fifo.freeCount() == 5);
+  printf("testMpmcFifo: %d records\n", receivedCount);
+  return 0;
+}
@@ -0,0 +1,69 @@
+/* Mutex priority inheritance, timeout and try lock. */
+#include "hostTest.h"
+
+#if NIL_CFG_USE_MUTEXES
+static MUTEX_DECL(mtx);
+static SEMAPHORE_DECL(go, 0);
+
+NIL_WORKING_AREA(waHigh, 0);
+NIL_THREAD(High, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(2));
+  nilMtxLock(&mtx);
+  TEST_LOG(10);
+  nilMtxUnlock(&mtx);
+  TEST_LOG(11);
+  /* Timeout while a lower priority thread owns the mutex.*/
+  nilThdSleep(TEST_TIME(10));
+  TEST_ASSERT(nilMtxLockTimeout(&mtx, TEST_TIME(3)) == NIL_MSG_TMO);
+  TEST_LOG(12);
+  TEST_ASSERT(!nilMtxTryLock(&mtx));
+  TEST_LOG(13);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waMedium, 0);
+NIL_THREAD(Medium, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(3));
+  TEST_LOG(20);
+  /* Low inherits the priority of High and preempts Medium.*/
+  nilSemSignal(&go);
+  TEST_LOG(21);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waLow, 0);
+NIL_THREAD(Low, arg) {
+  (void)arg;
+  nilMtxLock(&mtx);
+  nilSemWait(&go);
+  TEST_LOG(30);
+  /* High runs now.*/
+  nilMtxUnlock(&mtx);
+  TEST_LOG(31);
+  nilMtxLock(&mtx);
+  /* Hold the mutex until the end.*/
+  nilSemWait(&go);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("high", High, NULL, waHigh, sizeof(waHigh))
+NIL_THREADS_TABLE_ENTRY("medium", Medium, NULL, waMedium, sizeof(waMedium))
+NIL_THREADS_TABLE_ENTRY("low", Low, NULL, waLow, sizeof(waLow))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {20, 30, 10, 11, 21, 31, 12, 13};
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(30));
+  testCheckLog("testMutex", want, sizeof(want)/sizeof(want[0]));
+  /* Only the idle thread is running, no priority left inherited.*/
+  TEST_ASSERT(nil.current == nil.idlep && nil.next == nil.idlep);
+  TEST_ASSERT(mtx.owner == &nil.threads[2] && mtx.waiters == 0);
+  return 0;
+}
+#else  /* NIL_CFG_USE_MUTEXES */
+TEST_DISABLED("testMutex", "mutexes disabled")
+#endif  /* NIL_CFG_USE_MUTEXES */
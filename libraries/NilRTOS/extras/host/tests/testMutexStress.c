@@ -0,0 +1,101 @@
+/*
+ * Random nested mutex locks, timeouts and sleeps while holding a mutex.
+ * After each call the running thread must be the one priority
+ * inheritance selects.
+ */
+#include "hostTest.h"
+
+#if NIL_CFG_USE_MUTEXES
+#define NUM_WORKERS 7
+
+static mutex_t mtx[2] = {{NULL, 0}, {NULL, 0}};
+static unsigned seed = 7;
+static unsigned long lockCount;
+static unsigned long timeoutCount;
+
+static unsigned rnd(void) {
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0X7FFF;
+}
+
+/* The thread that runs for a priority slot.*/
+static thread_ref_t resolve(thread_ref_t tr) {
+  while (NIL_THD_IS_WTMTX(tr)) tr = tr->u1.mtxp->owner;
+  return tr;
+}
+
+static void check(void) {
+  int i;
+  for (i = 0; i <= NUM_WORKERS; i++) {
+    thread_ref_t tr = &nil.threads[i];
+    if ((nil.readymask & NIL_THD_MASK(tr)) && NIL_THD_IS_READY(resolve(tr))) {
+      TEST_ASSERT(nil.current == resolve(tr));
+      TEST_ASSERT(nil.next == tr);
+      return;
+    }
+  }
+  TEST_ASSERT(0);
+}
+
+NIL_THREAD(Worker, arg) {
+  (void)arg;
+  for (;;) {
+    /* 0: mtx[0], 1: mtx[1], 2: both in order.*/
+    unsigned n = rnd() % 3;
+    int a = n == 1 ? 1 : 0;
+    int b = n == 2 ? 1 : -1;
+    systime_t tmo = rnd() % 2 ? TIME_INFINITE : 1 + rnd() % 20;
+    msg_t msg = nilMtxLockTimeout(&mtx[a], tmo);
+    check();
+    if (msg == NIL_MSG_TMO) {
+      timeoutCount++;
+      continue;
+    }
+    TEST_ASSERT(mtx[a].owner == nil.current);
+    if (b > 0) {
+      nilMtxLock(&mtx[b]);
+      check();
+      TEST_ASSERT(mtx[b].owner == nil.current);
+    }
+    lockCount++;
+    nilThdSleep(1 + rnd() % 5);
+    check();
+    if (b > 0) {
+      nilMtxUnlock(&mtx[b]);
+      check();
+    }
+    nilMtxUnlock(&mtx[a]);
+    check();
+    nilThdSleep(1 + rnd() % 10);
+    check();
+  }
+}
+
+NIL_WORKING_AREA(waWorker0, 0);
+NIL_WORKING_AREA(waWorker1, 0);
+NIL_WORKING_AREA(waWorker2, 0);
+NIL_WORKING_AREA(waWorker3, 0);
+NIL_WORKING_AREA(waWorker4, 0);
+NIL_WORKING_AREA(waWorker5, 0);
+NIL_WORKING_AREA(waWorker6, 0);
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("worker0", Worker, NULL, waWorker0, sizeof(waWorker0))
+NIL_THREADS_TABLE_ENTRY("worker1", Worker, NULL, waWorker1, sizeof(waWorker1))
+NIL_THREADS_TABLE_ENTRY("worker2", Worker, NULL, waWorker2, sizeof(waWorker2))
+NIL_THREADS_TABLE_ENTRY("worker3", Worker, NULL, waWorker3, sizeof(waWorker3))
+NIL_THREADS_TABLE_ENTRY("worker4", Worker, NULL, waWorker4, sizeof(waWorker4))
+NIL_THREADS_TABLE_ENTRY("worker5", Worker, NULL, waWorker5, sizeof(waWorker5))
+NIL_THREADS_TABLE_ENTRY("worker6", Worker, NULL, waWorker6, sizeof(waWorker6))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(100000);
+  printf("testMutexStress: locks %lu timeouts %lu\n", lockCount, timeoutCount);
+  TEST_ASSERT(lockCount > 1000 && timeoutCount > 100);
+  return 0;
+}
+#else  /* NIL_CFG_USE_MUTEXES */
+TEST_DISABLED("testMutexStress", "mutexes disabled")
+#endif  /* NIL_CFG_USE_MUTEXES */
@@ -0,0 +1,56 @@
+/*
+ * Overlapping long sleeps.  In tick-less mode each sleep is longer than
+ * half the counter range and the second starts while the first is
+ * pending with no alarm in between, so it ends more than the counter
+ * range after the last alarm.
+ */
+#include "hostTest.h"
+
+/* 180 msec at F_CPU/64 in tick-less mode.*/
+#define LONG_SLEEP 45000
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  (void)arg;
+  nilThdSleep(LONG_SLEEP);
+  TEST_ASSERT(port_sim_now() == LONG_SLEEP);
+  TEST_LOG(10);
+#if NIL_CFG_TIMEDELTA > 0
+  /* The longest timeout while another long sleep is pending.*/
+  nilThdSleep(NIL_MAX_TIMEOUT);
+  TEST_ASSERT(port_sim_now() == LONG_SLEEP + NIL_MAX_TIMEOUT);
+  TEST_LOG(11);
+#endif
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread2, 0);
+NIL_THREAD(Thread2, arg) {
+  (void)arg;
+  /* Run without an alarm so the time base stays at the first sleep.*/
+  port_sim_run(25000);
+  nilThdSleep(LONG_SLEEP);
+  TEST_ASSERT(port_sim_now() == 25000 + LONG_SLEEP);
+  TEST_LOG(20);
+  nilThdSleep(LONG_SLEEP);
+  TEST_ASSERT(port_sim_now() == 25000 + 2*LONG_SLEEP);
+  TEST_LOG(21);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("thread2", Thread2, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+#if NIL_CFG_TIMEDELTA > 0
+  static const int want[] = {10, 20, 11, 21};
+#else
+  static const int want[] = {10, 20, 21};
+#endif
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(200000);
+  testCheckLog("testOverlapSleep", want, sizeof(want)/sizeof(want[0]));
+  return 0;
+}
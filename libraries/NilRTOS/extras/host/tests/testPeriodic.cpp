@@ -0,0 +1,63 @@
+// NilPeriodic release times, deadline misses and policies.
+#include "hostTest.h"
+#include "NilPeriodic.h"
+
+static NilPeriodic catchUp;
+static NilPeriodic skip;
+static uint32_t catchUpTimes[8];
+static uint32_t skipTimes[6];
+static int catchUpMet;
+static int skipMet;
+
+// Run a periodic loop, the fourth release overruns by 15 ticks.
+static void periodicLoop(NilPeriodic* p, uint8_t policy,
+                         uint32_t* times, int* met, int n) {
+  p->begin(TEST_TIME(10), policy);
+  for (int i = 0; i < n; i++) {
+    if (p->waitNextPeriod()) (*met)++;
+    times[i] = port_sim_now();
+    if (i == 3) nilThdSleep(TEST_TIME(25));
+  }
+}
+
+NIL_WORKING_AREA(waCatchUp, 0);
+NIL_THREAD(CatchUp, arg) {
+  (void)arg;
+  periodicLoop(&catchUp, NIL_PERIODIC_CATCH_UP, catchUpTimes, &catchUpMet, 8);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waSkip, 0);
+NIL_THREAD(Skip, arg) {
+  (void)arg;
+  periodicLoop(&skip, NIL_PERIODIC_SKIP, skipTimes, &skipMet, 6);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("catchup", CatchUp, NULL, waCatchUp, sizeof(waCatchUp))
+NIL_THREADS_TABLE_ENTRY("skip", Skip, NULL, waSkip, sizeof(waSkip))
+NIL_THREADS_TABLE_END()
+
+int main() {
+  static const uint32_t wantCatchUp[] = {10, 20, 30, 40, 65, 65, 70, 80};
+  static const uint32_t wantSkip[] = {10, 20, 30, 40, 70, 80};
+  Print pr;
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(100));
+  for (int i = 0; i < 8; i++) {
+    TEST_ASSERT(catchUpTimes[i] == TEST_TIME(wantCatchUp[i]));
+  }
+  for (int i = 0; i < 6; i++) {
+    TEST_ASSERT(skipTimes[i] == TEST_TIME(wantSkip[i]));
+  }
+  TEST_ASSERT(catchUp.missCount() == 2 && skip.missCount() == 1);
+  TEST_ASSERT(catchUpMet == 6 && skipMet == 5);
+  TEST_ASSERT(catchUp.maxLateness() == TEST_TIME(15));
+  TEST_ASSERT(skip.maxLateness() == TEST_TIME(15));
+  TEST_ASSERT(catchUp.skipCount() == 0 && skip.skipCount() == 2);
+  printf("testPeriodic:\n");
+  catchUp.printStats(&pr);
+  skip.printStats(&pr);
+  return 0;
+}
@@ -0,0 +1,64 @@
+/* Memory pool allocation, timeout, free and low-water mark. */
+#include "hostTest.h"
+
+static char blocks[3][16];
+static memory_pool_t pool;
+static void *held[3];
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  int i;
+  void *p;
+  (void)arg;
+  for (i = 0; i < 3; i++) {
+    held[i] = nilPoolAlloc(&pool);
+    TEST_ASSERT(held[i]);
+  }
+  TEST_ASSERT(nilPoolGetFreeCountI(&pool) == 0);
+  TEST_ASSERT(nilPoolGetMinFreeCountI(&pool) == 0);
+  nilSysLock();
+  TEST_ASSERT(nilPoolAllocI(&pool) == NULL);
+  nilSysUnlock();
+  TEST_ASSERT(nilPoolAllocTimeout(&pool, TEST_TIME(2)) == NULL);
+  TEST_LOG(10);
+  /* Thread2 frees a block.*/
+  p = nilPoolAlloc(&pool);
+  TEST_LOG(11);
+  TEST_ASSERT(p == held[1]);
+  nilPoolFree(&pool, p);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread2, 0);
+NIL_THREAD(Thread2, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(5));
+  TEST_LOG(20);
+  /* Thread1 preempts.*/
+  nilPoolFree(&pool, held[1]);
+  TEST_LOG(21);
+  nilSysLock();
+  nilPoolFreeI(&pool, held[0]);
+  nilPoolFreeI(&pool, held[2]);
+  nilSysUnlock();
+  TEST_ASSERT(nilPoolGetFreeCountI(&pool) == 3);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("thread2", Thread2, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  int n = 0;
+  pool_header_t *bp;
+  static const int want[] = {10, 20, 11, 21};
+  nilPoolInit(&pool, blocks, sizeof(blocks[0]), 3);
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(20));
+  testCheckLog("testPool", want, sizeof(want)/sizeof(want[0]));
+  for (bp = pool.next; bp; bp = bp->next) n++;
+  TEST_ASSERT(n == 3 && nilPoolGetMinFreeCountI(&pool) == 0);
+  return 0;
+}
@@ -0,0 +1,66 @@
+/* Semaphore counter, waiters mask and reset. */
+#include "hostTest.h"
+
+static SEMAPHORE_DECL(sem, 0);
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(2));
+  TEST_LOG(10);
+  TEST_ASSERT(nilSemWait(&sem) == NIL_MSG_OK);
+  TEST_LOG(11);
+  nilThdSleep(TEST_TIME(3));
+  TEST_ASSERT(nilSemWait(&sem) == NIL_MSG_RST);
+  TEST_LOG(12);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread2, 0);
+NIL_THREAD(Thread2, arg) {
+  (void)arg;
+  TEST_LOG(20);
+  TEST_ASSERT(nilSemWait(&sem) == NIL_MSG_OK);
+  TEST_LOG(21);
+  TEST_ASSERT(nilSemWait(&sem) == NIL_MSG_RST);
+  TEST_LOG(22);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread3, 0);
+NIL_THREAD(Thread3, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(5));
+  TEST_ASSERT(sem.cnt == -2);
+#if NIL_CFG_USE_READY_MASK
+  TEST_ASSERT(sem.waiters == 3);
+#endif
+  TEST_LOG(30);
+  nilSemSignal(&sem);
+  TEST_LOG(31);
+  nilSemSignal(&sem);
+  TEST_LOG(32);
+  nilThdSleep(TEST_TIME(5));
+  TEST_ASSERT(sem.cnt == -2);
+  nilSemReset(&sem, 1);
+  TEST_LOG(33);
+  TEST_ASSERT(sem.cnt == 1);
+#if NIL_CFG_USE_READY_MASK
+  TEST_ASSERT(sem.waiters == 0);
+#endif
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("thread2", Thread2, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_ENTRY("thread3", Thread3, NULL, waThread3, sizeof(waThread3))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {20, 10, 30, 11, 31, 21, 32, 12, 22, 33};
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(20));
+  testCheckLog("testSemReset", want, sizeof(want)/sizeof(want[0]));
+  return 0;
+}
@@ -0,0 +1,54 @@
+/* Semaphore wait, timeout and signal order. */
+#include "hostTest.h"
+
+static SEMAPHORE_DECL(sem, 0);
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  (void)arg;
+  TEST_LOG(10);
+  TEST_ASSERT(nilSemWaitTimeout(&sem, TEST_TIME(5)) == NIL_MSG_TMO);
+  TEST_LOG(11);
+  TEST_ASSERT(nilSemWait(&sem) == NIL_MSG_OK);
+  TEST_LOG(12);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread2, 0);
+NIL_THREAD(Thread2, arg) {
+  (void)arg;
+  TEST_LOG(20);
+  nilThdSleep(TEST_TIME(3));
+  TEST_LOG(21);
+  TEST_ASSERT(nilSemWait(&sem) == NIL_MSG_OK);
+  TEST_LOG(22);
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waThread3, 0);
+NIL_THREAD(Thread3, arg) {
+  (void)arg;
+  TEST_LOG(30);
+  nilThdSleep(TEST_TIME(10));
+  TEST_LOG(31);
+  /* Thread1 waited first but Thread2 has lower priority so Thread1 runs.*/
+  nilSemSignal(&sem);
+  TEST_LOG(32);
+  nilSemSignal(&sem);
+  TEST_LOG(33);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("thread2", Thread2, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_ENTRY("thread3", Thread3, NULL, waThread3, sizeof(waThread3))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {10, 20, 30, 21, 11, 31, 12, 32, 22, 33};
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(20));
+  testCheckLog("testSemaphore", want, sizeof(want)/sizeof(want[0]));
+  return 0;
+}
@@ -0,0 +1,71 @@
+/* Random sleeps and semaphore timeouts, each wakeup must be on time. */
+#include "hostTest.h"
+
+static SEMAPHORE_DECL(sem, 0);
+static unsigned seed = 1;
+static unsigned long wakeCount;
+static unsigned long signalCount;
+
+static unsigned rnd(void) {
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0X7FFF;
+}
+
+NIL_THREAD(Waiter, arg) {
+  (void)arg;
+  for (;;) {
+    systime_t d = 1 + rnd() % 40;
+    uint32_t t0 = port_sim_now();
+    if (rnd() & 1) {
+      nilThdSleep(d);
+      TEST_ASSERT(port_sim_now() == t0 + TEST_TIMEOUT(d));
+    } else {
+      msg_t msg = nilSemWaitTimeout(&sem, d);
+      if (msg == NIL_MSG_TMO) {
+        TEST_ASSERT(port_sim_now() == t0 + TEST_TIMEOUT(d));
+      } else {
+        TEST_ASSERT(msg == NIL_MSG_OK);
+        TEST_ASSERT(port_sim_now() < t0 + TEST_TIMEOUT(d));
+        signalCount++;
+      }
+    }
+    wakeCount++;
+  }
+}
+
+NIL_THREAD(Signaler, arg) {
+  (void)arg;
+  for (;;) {
+    nilThdSleep(1 + rnd() % 7);
+    nilSemSignal(&sem);
+    if (sem.cnt > 0) nilSemReset(&sem, 0);
+  }
+}
+
+NIL_WORKING_AREA(waThread0, 0);
+NIL_WORKING_AREA(waThread1, 0);
+NIL_WORKING_AREA(waThread2, 0);
+NIL_WORKING_AREA(waThread3, 0);
+NIL_WORKING_AREA(waThread4, 0);
+NIL_WORKING_AREA(waThread5, 0);
+NIL_WORKING_AREA(waThread6, 0);
+NIL_WORKING_AREA(waThread7, 0);
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("waiter0", Waiter, NULL, waThread0, sizeof(waThread0))
+NIL_THREADS_TABLE_ENTRY("waiter1", Waiter, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("waiter2", Waiter, NULL, waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_ENTRY("signal", Signaler, NULL, waThread3, sizeof(waThread3))
+NIL_THREADS_TABLE_ENTRY("waiter4", Waiter, NULL, waThread4, sizeof(waThread4))
+NIL_THREADS_TABLE_ENTRY("waiter5", Waiter, NULL, waThread5, sizeof(waThread5))
+NIL_THREADS_TABLE_ENTRY("waiter6", Waiter, NULL, waThread6, sizeof(waThread6))
+NIL_THREADS_TABLE_ENTRY("waiter7", Waiter, NULL, waThread7, sizeof(waThread7))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(200000);
+  printf("testSleepStress: wakeups %lu signaled %lu\n", wakeCount, signalCount);
+  TEST_ASSERT(wakeCount > 10000 && signalCount > 1000);
+  return 0;
+}
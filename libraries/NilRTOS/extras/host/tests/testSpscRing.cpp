@@ -0,0 +1,75 @@
+// NilSpscRing order, batched wakeup, timeouts and overruns.
+#include "hostTest.h"
+#include "NilFIFO.h"
+
+static NilSpscRing<int, 8> ring;
+static NilSpscRing<int, 2> small;
+static int nextGet;
+static int wakeups;
+static bool done;
+
+static int nextPut;
+
+// Called by port_sim_tick() in ISR context like an ADC ISR, one record
+// each tick.
+static void producer(void) {
+  if (port_sim_now() % TEST_TIME(1)) return;
+  TEST_ASSERT(ring.putI(nextPut));
+  nextPut++;
+}
+
+NIL_WORKING_AREA(waConsumer, 0);
+NIL_THREAD(Consumer, arg) {
+  int data;
+  (void)arg;
+  // Nothing to get, immediate and real timeouts.
+  TEST_ASSERT(!ring.get(&data));
+  TEST_ASSERT(!ring.waitData(1, TIME_IMMEDIATE));
+  TEST_ASSERT(!ring.waitData(1, TEST_TIMEOUT(2)));
+
+  // Thread producer, the ring wakes the consumer once for four records.
+  TEST_ASSERT(ring.waitData(4, TIME_INFINITE));
+  TEST_ASSERT(ring.dataCount() == 4);
+  while (ring.get(&data)) TEST_ASSERT(data == nextGet++);
+  TEST_ASSERT(nextGet == 4);
+
+  // ISR producer, wake up for each batch of four records.
+  nextPut = nextGet;
+  port_sim_tick_hook = producer;
+  while (nextGet < 100) {
+    TEST_ASSERT(ring.waitData(4, TIME_INFINITE));
+    wakeups++;
+    while (ring.get(&data)) TEST_ASSERT(data == nextGet++);
+  }
+  port_sim_tick_hook = NULL;
+  TEST_ASSERT(wakeups == 96/4);
+  done = true;
+  TEST_THREAD_END();
+}
+
+NIL_WORKING_AREA(waProducer, 0);
+NIL_THREAD(Producer, arg) {
+  (void)arg;
+  // Let the consumer time out.
+  nilThdSleep(TEST_TIMEOUT(2) + TEST_TIME(2));
+  for (int i = 0; i < 4; i++) TEST_ASSERT(ring.put(i));
+  // Full ring, records are dropped and counted.
+  TEST_ASSERT(small.put(1) && small.put(2));
+  TEST_ASSERT(!small.put(3) && !small.put(4));
+  TEST_ASSERT(small.overrunCount() == 2);
+  TEST_ASSERT(small.freeCount() == 0);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("consumer", Consumer, NULL, waConsumer, sizeof(waConsumer))
+NIL_THREADS_TABLE_ENTRY("producer", Producer, NULL, waProducer, sizeof(waProducer))
+NIL_THREADS_TABLE_END()
+
+int main() {
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(200));
+  TEST_ASSERT(done);
+  printf("testSpscRing: %d records, %d wakeups\n", nextGet, wakeups);
+  return 0;
+}
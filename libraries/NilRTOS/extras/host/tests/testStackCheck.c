@@ -0,0 +1,43 @@
+/* Stack guard overwrite halts at the next switch with the thread name. */
+#include <string.h>
+#include "hostTest.h"
+
+NIL_WORKING_AREA(waVictim, 0);
+
+#if NIL_CFG_STACK_CHECK
+/* Replaces the weak port_halt() of the host port.*/
+void port_halt(void) {
+  printf("testStackCheck: halt %s\n", nil.dbg_msg);
+  TEST_ASSERT(strcmp(nil.dbg_msg, "victim") == 0);
+  exit(0);
+}
+#endif
+
+NIL_WORKING_AREA(waOther, 0);
+NIL_THREAD(Other, arg) {
+  (void)arg;
+  for (;;) nilThdSleep(1);
+}
+
+NIL_THREAD(Victim, arg) {
+  (void)arg;
+  nilThdSleep(TEST_TIME(5));
+  /* An overflow reaches the bottom of the working area.*/
+  memset(waVictim, 0, 2);
+  nilThdSleep(1);
+  TEST_ASSERT(!NIL_CFG_STACK_CHECK);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("other", Other, NULL, waOther, sizeof(waOther))
+NIL_THREADS_TABLE_ENTRY("victim", Victim, NULL, waVictim, sizeof(waVictim))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(10));
+  TEST_ASSERT(!NIL_CFG_STACK_CHECK);
+  printf("testStackCheck: stack check disabled\n");
+  return 0;
+}
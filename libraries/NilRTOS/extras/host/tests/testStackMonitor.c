@@ -0,0 +1,70 @@
+/* Stack monitor counts match a full scan of the 0X55 fill. */
+#include <string.h>
+#include "hostTest.h"
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_WORKING_AREA(waThread2, 0);
+
+/* Unused bytes found by a full scan, like nilUnusedStack().*/
+static size_t fullScan(uint8_t nt) {
+  const uint8_t* p = (const uint8_t*)nil_thd_configs[nt].wap +
+                     NIL_STACK_GUARD_SIZE;
+  const uint8_t* end = (const uint8_t*)nil_thd_configs[nt].wap +
+                       nil_thd_configs[nt].size;
+  size_t n = 0;
+  while (p + n < end && p[n] == 0X55) n++;
+  return n;
+}
+
+/* Uses about n bytes of stack.*/
+static void useStack(size_t n) {
+  volatile uint8_t buf[4096];
+  if (n > sizeof(buf)) n = sizeof(buf);
+  /* Stacks grow down, touch the top n bytes.*/
+  while (n) buf[sizeof(buf) - n--] = 0;
+}
+
+/* Stack bytes used by each thread in the current phase.*/
+static size_t use[2] = {100, 500};
+
+NIL_THREAD(Thread, arg) {
+  size_t* n = (size_t*)arg;
+  for (;;) {
+    useStack(*n);
+    /* The idle thread is entered each tick.*/
+    nilThdSleep(TEST_TIME(1));
+  }
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread, &use[0], waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_ENTRY("thread2", Thread, &use[1], waThread2, sizeof(waThread2))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+#if NIL_CFG_STACK_MONITOR
+  int i;
+  memset(waThread1, 0X55, sizeof(waThread1));
+  memset(waThread2, 0X55, sizeof(waThread2));
+  TEST_ASSERT(nilSysBegin());
+  for (i = 0; i < 3; i++) {
+    /* The count is never below the real count.*/
+    port_sim_run(TEST_TIME(10));
+    TEST_ASSERT(nilStackMonitorUnused(0) >= fullScan(0));
+    TEST_ASSERT(nilStackMonitorUnused(1) >= fullScan(1));
+    /* A complete scan of both stacks, the chunk is at least one byte.*/
+    port_sim_run(TEST_TIME(sizeof(waThread1) + sizeof(waThread2)));
+    TEST_ASSERT(nilStackMonitorUnused(0) == fullScan(0));
+    TEST_ASSERT(nilStackMonitorUnused(1) == fullScan(1));
+    printf("testStackMonitor: %u %u\n", (unsigned)nilStackMonitorUnused(0),
+           (unsigned)nilStackMonitorUnused(1));
+    use[0] += 1000;
+    use[1] += 500;
+  }
+  TEST_ASSERT(nilStackMonitorUnused(0) < nilStackMonitorUnused(1));
+#else
+  (void)fullScan;
+  printf("testStackMonitor: stack monitor disabled\n");
+#endif
+  return 0;
+}
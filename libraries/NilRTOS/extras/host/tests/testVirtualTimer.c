@@ -0,0 +1,86 @@
+/* Virtual timers, one-shot, periodic, reset and re-arm from a callback. */
+#include "hostTest.h"
+
+#if NIL_CFG_USE_VIRTUAL_TIMERS
+static virtual_timer_t oneShot;
+static virtual_timer_t periodic;
+static virtual_timer_t chain;
+static virtual_timer_t cancel;
+
+static SEMAPHORE_DECL(sem, 0);
+
+static uint32_t periodicTime[8];
+static int periodicCount;
+static int chainCount;
+
+static void oneShotCb(void *p) {
+  TEST_ASSERT(!nilVTIsArmedI(&oneShot));
+  TEST_ASSERT(port_sim_now() == TEST_TIME(10));
+  TEST_LOG(1);
+  nilSemSignalI((semaphore_t *)p);
+}
+
+static void periodicCb(void *p) {
+  (void)p;
+  TEST_ASSERT(nilVTIsArmedI(&periodic));
+  periodicTime[periodicCount++] = port_sim_now();
+  /* The callback stops its own timer.*/
+  if (periodicCount == 5)
+    nilVTResetI(&periodic);
+}
+
+static void chainCb(void *p) {
+  (void)p;
+  /* A one-shot timer re-armed from its callback.*/
+  if (++chainCount < 3)
+    nilVTSetI(&chain, TEST_TIME(7), 0, chainCb, NULL);
+}
+
+static void cancelCb(void *p) {
+  (void)p;
+  TEST_ASSERT(0);
+}
+
+NIL_WORKING_AREA(waThread1, 0);
+NIL_THREAD(Thread1, arg) {
+  (void)arg;
+  nilVTSet(&oneShot, TEST_TIME(10), 0, oneShotCb, &sem);
+  nilVTSet(&periodic, TEST_TIME(4), TEST_TIME(6), periodicCb, NULL);
+  nilVTSet(&chain, TEST_TIME(7), 0, chainCb, NULL);
+  nilVTSet(&cancel, TEST_TIME(20), 0, cancelCb, NULL);
+  TEST_ASSERT(nilSemWaitTimeout(&sem, TEST_TIME(100)) == NIL_MSG_OK);
+  TEST_ASSERT(port_sim_now() == TEST_TIME(10));
+  TEST_LOG(2);
+  nilThdSleep(TEST_TIME(5));
+  nilVTReset(&cancel);
+  nilVTReset(&cancel);
+  TEST_ASSERT(!nilVTIsArmedI(&cancel));
+  /* Re-arming an armed timer moves it.*/
+  nilVTSet(&oneShot, TEST_TIME(50), 0, oneShotCb, &sem);
+  nilVTSet(&oneShot, TEST_TIME(60), 0, cancelCb, NULL);
+  nilVTReset(&oneShot);
+  TEST_LOG(3);
+  TEST_THREAD_END();
+}
+
+NIL_THREADS_TABLE_BEGIN()
+NIL_THREADS_TABLE_ENTRY("thread1", Thread1, NULL, waThread1, sizeof(waThread1))
+NIL_THREADS_TABLE_END()
+
+int main(void) {
+  static const int want[] = {1, 2, 3};
+  int i;
+  TEST_ASSERT(nilSysBegin());
+  port_sim_run(TEST_TIME(200));
+  testCheckLog("testVirtualTimer", want, sizeof(want)/sizeof(want[0]));
+  TEST_ASSERT(periodicCount == 5);
+  for (i = 0; i < periodicCount; i++)
+    TEST_ASSERT(periodicTime[i] == TEST_TIME(4 + 6*i));
+  TEST_ASSERT(chainCount == 3);
+  TEST_ASSERT(!nilVTIsArmedI(&periodic));
+  TEST_ASSERT(nil.vtlist == NULL);
+  return 0;
+}
+#else  /* NIL_CFG_USE_VIRTUAL_TIMERS */
+TEST_DISABLED("testVirtualTimer", "virtual timers disabled")
+#endif  /* NIL_CFG_USE_VIRTUAL_TIMERS */
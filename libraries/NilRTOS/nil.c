@@ -44,10 +44,272 @@ nil_system_t nil;
 /* Module local variables.                                                   */
 /*===========================================================================*/
 
+#if NIL_CFG_STACK_CHECK || defined(__DOXYGEN__)
+/**
+ * @brief   Stack guard of the idle thread, always intact.
+ */
+static uint16_t nil_idle_guard = NIL_STACK_GUARD;
+#endif
+
+#if NIL_CFG_STACK_MONITOR || defined(__DOXYGEN__)
+/**
+ * @brief   Thread being scanned by the stack monitor.
+ */
+static thread_ref_t nil_sm_thread;
+
+/**
+ * @brief   Stack monitor scan pointer, NULL at the start of a thread.
+ */
+static uint8_t *nil_sm_ptr;
+#endif
+
 /*===========================================================================*/
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Returns the highest priority thread in a thread mask.
+ * @details The lowest set bit is located with a binary search so the
+ *          cost does not depend on the number of threads.
+ *
+ * @param[in] mask      the thread mask, must not be zero
+ * @return              Reference to the highest priority thread.
+ */
+static inline thread_ref_t nil_mask_first(thdmask_t mask) {
+  uint8_t n = 0;
+
+  if ((mask & 0XFF) == 0) {
+    mask >>= 8;
+    n += 8;
+  }
+  if ((mask & 0X0F) == 0) {
+    mask >>= 4;
+    n += 4;
+  }
+  if ((mask & 0X03) == 0) {
+    mask >>= 2;
+    n += 2;
+  }
+  if ((mask & 0X01) == 0) {
+    n += 1;
+  }
+  return &nil.threads[n];
+}
+
+#if NIL_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the thread that runs in place of a thread.
+ * @details A thread waiting on a mutex keeps its bit in the ready mask,
+ *          the mutex owner runs in its place at its priority.  Chains of
+ *          mutex waits are followed to the final owner.
+ * @note    A cycle in the chain is a deadlock and this function does not
+ *          return.
+ *
+ * @param[in] tr        reference to the @p thread_t object
+ * @return              The thread to run for @p tr.
+ */
+static thread_ref_t nil_mtx_resolve(thread_ref_t tr) {
+
+  while (NIL_THD_IS_WTMTX(tr))
+    tr = tr->u1.mtxp->owner;
+  return tr;
+}
+
+/**
+ * @brief   Returns the highest priority thread in the ready mask that can
+ *          run, itself or through a mutex owner.
+ *
+ * @return              The thread that sets the running priority.
+ */
+static thread_ref_t nil_sch_first(void) {
+  thdmask_t mask = nil.readymask;
+  thread_ref_t tr;
+
+  /* The idle thread is always ready so the loop terminates.*/
+  while (TRUE) {
+    tr = nil_mask_first(mask);
+    if (NIL_THD_IS_READY(nil_mtx_resolve(tr)))
+      return tr;
+    mask &= ~NIL_THD_MASK(tr);
+  }
+}
+#endif /* NIL_CFG_USE_MUTEXES */
+
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Inserts a thread in the timeout list.
+ * @details The list is ordered by expiration time and the @p timeout
+ *          field of each thread is relative to the previous thread.
+ *
+ * @param[in] tr        reference to the @p thread_t object
+ * @param[in] time      the number of ticks before the timeout
+ */
+static void nil_tmo_insert(thread_ref_t tr, systime_t time) {
+  thread_ref_t prev = NULL;
+  thread_ref_t next = nil.tmlist;
+
+  /* Threads with the same expiration time are kept in FIFO order.*/
+  while ((next != NULL) && (next->timeout <= time)) {
+    time -= next->timeout;
+    prev = next;
+    next = next->tmnext;
+  }
+  tr->timeout = time;
+  tr->tmprev = prev;
+  tr->tmnext = next;
+  if (next != NULL) {
+    next->timeout -= time;
+    next->tmprev = tr;
+  }
+  if (prev != NULL)
+    prev->tmnext = tr;
+  else
+    nil.tmlist = tr;
+}
+
+/**
+ * @brief   Removes a thread from the timeout list if present.
+ * @details The remaining time of the removed thread is added to the next
+ *          thread so later expiration times are unchanged.
+ *
+ * @param[in] tr        reference to the @p thread_t object
+ */
+static void nil_tmo_remove(thread_ref_t tr) {
+  thread_ref_t next = tr->tmnext;
+
+  if ((tr->tmprev == NULL) && (nil.tmlist != tr))
+    return;
+  if (next != NULL) {
+    next->timeout += tr->timeout;
+    next->tmprev = tr->tmprev;
+  }
+  if (tr->tmprev != NULL)
+    tr->tmprev->tmnext = next;
+  else
+    nil.tmlist = next;
+  tr->tmprev = NULL;
+}
+#endif /* NIL_CFG_TIMEDELTA == 0 */
+
+#if NIL_CFG_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Schedules a tick event for a timeout.
+ * @details The alarm is moved if the timeout expires before the next
+ *          scheduled tick event.
+ *
+ * @param[in] timeout   the number of ticks before the timeout
+ * @return              The timeout relative to @p nil.lasttime.
+ */
+static systime_t nil_alarm_insert(systime_t timeout) {
+  systime_t now, time;
+
+  /* TIMEDELTA makes sure to have enough time to reprogram the timer
+     before the free-running timer counter reaches the selected timeout.*/
+  if (timeout < NIL_CFG_TIMEDELTA)
+    timeout = NIL_CFG_TIMEDELTA;
+  nilDbgAssert(timeout <= NIL_MAX_TIMEOUT,
+               "nil_alarm_insert(), #1", "too long");
+
+  now = nilTimeNowI();
+  time = now + timeout;
+  if (nil.lasttime == nil.nexttime) {
+    /* No timeouts pending and the alarm is stopped, the time base is
+       moved to the current time so the counter can wrap while idle.
+       A long timeout is reached with intermediate alarms.*/
+    nil.lasttime = now;
+    nil.nexttime = now + (timeout < NIL_ALARM_MAX_DELTA ?
+                          timeout : NIL_ALARM_MAX_DELTA);
+    port_timer_set_alarm(nil.nexttime);
+  }
+  else if (nilTimeIsWithin(time, nil.lasttime, nil.nexttime)) {
+    port_timer_set_alarm(time);
+    nil.nexttime = time;
+  }
+  return time - nil.lasttime;
+}
+#endif /* NIL_CFG_TIMEDELTA > 0 */
+
+#if (NIL_CFG_USE_VIRTUAL_TIMERS && NIL_CFG_TIMEDELTA == 0) ||                \
+    defined(__DOXYGEN__)
+/**
+ * @brief   Inserts a virtual timer in the timers list.
+ * @details The list is ordered by expiration time like the timeout list.
+ *
+ * @param[in] vtp       pointer to a @p virtual_timer_t structure
+ * @param[in] time      the number of ticks before the timer expires
+ */
+static void nil_vt_insert(virtual_timer_t *vtp, systime_t time) {
+  virtual_timer_t *prev = NULL;
+  virtual_timer_t *next = nil.vtlist;
+
+  while ((next != NULL) && (next->timeout <= time)) {
+    time -= next->timeout;
+    prev = next;
+    next = next->next;
+  }
+  vtp->timeout = time;
+  vtp->prev = prev;
+  vtp->next = next;
+  if (next != NULL) {
+    next->timeout -= time;
+    next->prev = vtp;
+  }
+  if (prev != NULL)
+    prev->next = vtp;
+  else
+    nil.vtlist = vtp;
+}
+
+/**
+ * @brief   Removes a virtual timer from the timers list if present.
+ *
+ * @param[in] vtp       pointer to a @p virtual_timer_t structure
+ */
+static void nil_vt_remove(virtual_timer_t *vtp) {
+  virtual_timer_t *next = vtp->next;
+
+  if (!nilVTIsArmedI(vtp))
+    return;
+  if (next != NULL) {
+    next->timeout += vtp->timeout;
+    next->prev = vtp->prev;
+  }
+  if (vtp->prev != NULL)
+    vtp->prev->next = next;
+  else
+    nil.vtlist = next;
+  vtp->prev = NULL;
+}
+#endif /* NIL_CFG_USE_VIRTUAL_TIMERS && NIL_CFG_TIMEDELTA == 0 */
+
+/**
+ * @brief   Wakes up a thread with a timeout message.
+ * @details Timeout on semaphores requires a special handling because the
+ *          semaphore counter must be incremented.
+ *
+ * @param[in] tr        reference to the @p thread_t object
+ */
+static void nil_tmo_wakeup(thread_ref_t tr) {
+
+  if (NIL_THD_IS_WTSEM(tr)) {
+    tr->u1.semp->cnt++;
+#if NIL_CFG_USE_READY_MASK
+    tr->u1.semp->waiters &= ~NIL_THD_MASK(tr);
+#endif
+  }
+  else if (NIL_THD_IS_SUSP(tr))
+    *tr->u1.trp = NULL;
+#if NIL_CFG_USE_EVENTS
+  else if (NIL_THD_IS_WTANY(tr) || NIL_THD_IS_WTALL(tr))
+    tr->u1.efp->waiters &= ~NIL_THD_MASK(tr);
+#endif
+#if NIL_CFG_USE_MUTEXES
+  else if (NIL_THD_IS_WTMTX(tr))
+    tr->u1.mtxp->waiters &= ~NIL_THD_MASK(tr);
+#endif
+  nilSchReadyI(tr, NIL_MSG_TMO);
+}
+
 /*===========================================================================*/
 /* Module interrupt handlers.                                                */
 /*===========================================================================*/
@@ -81,16 +343,44 @@ void nilSysInit(void) {
        tr++, tcp++) {
     tr->state = NIL_THD_READY;
     tr->timeout = 0;
+#if NIL_CFG_USE_READY_MASK
+    nil.readymask |= NIL_THD_MASK(tr);
+#endif
 
     /* Port dependent thread initialization.*/
     SETUP_CONTEXT(tr, tcp->wap, tcp->size, tcp->funcp, tcp->arg);
 
+#if NIL_CFG_STACK_CHECK
+    /* The guard is at the bottom of the working area, stacks grow down.*/
+    tr->guardp = (uint16_t *)tcp->wap;
+    *tr->guardp = NIL_STACK_GUARD;
+#endif
+
+#if NIL_CFG_STACK_MONITOR
+    /* The monitor only lowers the count.*/
+    tr->stkunused = tcp->size - NIL_STACK_GUARD_SIZE;
+#endif
+
     /* Initialization hook.*/
 #if defined(NIL_CFG_THREAD_EXT_INIT_HOOK)
     NIL_CFG_THREAD_EXT_INIT_HOOK(tr);
 #endif
   }
 
+#if NIL_CFG_USE_READY_MASK
+  /* The idle thread is always ready.*/
+  nil.readymask |= NIL_THD_MASK(tr);
+#endif
+
+#if NIL_CFG_STACK_CHECK
+  /* The idle thread runs on the main stack, it has no guard.*/
+  tr->guardp = &nil_idle_guard;
+#endif
+
+#if NIL_CFG_STACK_MONITOR
+  nil_sm_thread = nil.threads;
+#endif
+
   /* Runs the highest priority thread, the current one becomes the null
      thread.*/
   nil.current = nil.next = nil.threads;
@@ -112,41 +402,62 @@ void nilSysInit(void) {
  * @iclass
  */
 void nilSysTimerHandlerI(void) {
+#if NIL_CFG_USE_VIRTUAL_TIMERS
+  virtual_timer_t *vtp;
+#endif
 
 #if NIL_CFG_TIMEDELTA == 0
-  thread_ref_t tr = &nil.threads[0];
+  thread_ref_t tr;
+
+  /* Keeps the run time of a thread that runs for many ticks from
+     overflowing the 16-bit time stamp.*/
+  NIL_CPU_USAGE_UPDATE(nil.current);
   nil.systime++;
-  do {
-    /* Is the thread in a wait state with timeout?.*/
-    if (tr->timeout > 0) {
 
+  /* Only the first thread in the timeout list is decremented, threads
+     following it with a zero delta expire in the same tick.*/
+  tr = nil.tmlist;
+  if ((tr != NULL) && (--tr->timeout == 0)) {
+    do {
       nilDbgAssert(!NIL_THD_IS_READY(tr),
                    "nilSysTimerHandlerI(), #1", "is ready");
 
-     /* Did the timer reach zero?*/
-      if (--tr->timeout == 0) {
-        /* Timeout on semaphores requires a special handling because the
-           semaphore counter must be incremented.*/
-        if (NIL_THD_IS_WTSEM(tr))
-          tr->u1.semp->cnt++;
-        else if (NIL_THD_IS_SUSP(tr))
-          tr->u1.trp = NULL;
-        nilSchReadyI(tr, NIL_MSG_TMO);
-      }
-    }
-    /* Lock released in order to give a preemption chance on those
-       architectures supporting IRQ preemption.*/
-    nilSysUnlockFromISR();
-    tr++;
-    nilSysLockFromISR();
-#if WHG_MOD
-  } while (tr < nil.idlep);
-#else  /* WHG_MOD */
-  } while (tr < &nil.threads[NIL_CFG_NUM_THREADS]);
-#endif  /* WHG_MOD */
+      /* The thread is also removed from the timeout list.*/
+      nil_tmo_wakeup(tr);
+
+      /* Lock released in order to give a preemption chance on those
+         architectures supporting IRQ preemption.*/
+      nilSysUnlockFromISR();
+      nilSysLockFromISR();
+      tr = nil.tmlist;
+    } while ((tr != NULL) && (tr->timeout == 0));
+  }
+
+#if NIL_CFG_USE_VIRTUAL_TIMERS
+  vtp = nil.vtlist;
+  if ((vtp != NULL) && (--vtp->timeout == 0)) {
+    do {
+      /* A periodic timer is re-armed before its callback runs so the
+         callback can reset it.*/
+      nil_vt_remove(vtp);
+      if (vtp->period != 0)
+        nil_vt_insert(vtp, vtp->period);
+      vtp->func(vtp->par);
+
+      nilSysUnlockFromISR();
+      nilSysLockFromISR();
+      vtp = nil.vtlist;
+    } while ((vtp != NULL) && (vtp->timeout == 0));
+  }
+#endif
 #else
   thread_ref_t tr = &nil.threads[0];
   systime_t next = 0;
+#if NIL_CFG_USE_VIRTUAL_TIMERS
+  virtual_timer_t **vtpp = &nil.vtlist;
+  virtual_timer_t *fired = NULL;
+  virtual_timer_t **firedpp = &fired;
+#endif
 
   nilDbgAssert(nil.nexttime == port_timer_get_alarm(),
                "nilSysTimerHandlerI(), #1", "time mismatch");
@@ -162,16 +473,10 @@ void nilSysTimerHandlerI(void) {
 
       tr->timeout -= nil.nexttime - nil.lasttime;
       if (tr->timeout == 0) {
-        /* Timeout on semaphores requires a special handling because the
-           semaphore counter must be incremented.*/
-        if (NIL_THD_IS_WTSEM(tr))
-          tr->u1.semp->cnt++;
-        else if (NIL_THD_IS_SUSP(tr))
-          tr->u1.trp = NULL;
-        nilSchReadyI(tr, NIL_MSG_TMO);
+        nil_tmo_wakeup(tr);
       }
       else {
-        if (tr->timeout <= next - 1)
+        if (tr->timeout <= (systime_t)(next - 1))
           next = tr->timeout;
       }
     }
@@ -186,6 +491,34 @@ void nilSysTimerHandlerI(void) {
   } while (tr < &nil.threads[NIL_CFG_NUM_THREADS]);
 #endif  /* WHG_MOD */
 
+#if NIL_CFG_USE_VIRTUAL_TIMERS
+  while ((vtp = *vtpp) != NULL) {
+    nilDbgAssert(vtp->timeout >= nil.nexttime - nil.lasttime,
+                 "nilSysTimerHandlerI(), #4", "skipped one");
+
+    vtp->timeout -= nil.nexttime - nil.lasttime;
+    if (vtp->timeout == 0) {
+      /* Expired timers are queued, the callbacks run after the time base
+         is moved so they can arm timers.*/
+      *firedpp = vtp;
+      firedpp = &vtp->fnext;
+      if (vtp->period == 0) {
+        *vtpp = vtp->next;
+        continue;
+      }
+      vtp->timeout = vtp->period;
+    }
+    if (vtp->timeout <= (systime_t)(next - 1))
+      next = vtp->timeout;
+    vtpp = &vtp->next;
+  }
+  *firedpp = NULL;
+#endif
+
+  /* The time base must not fall more than NIL_ALARM_MAX_DELTA behind the
+     counter so timeouts relative to it fit in a systime_t.*/
+  if (next > NIL_ALARM_MAX_DELTA)
+    next = NIL_ALARM_MAX_DELTA;
   nil.lasttime = nil.nexttime;
   if (next > 0) {
     nil.nexttime += next;
@@ -195,6 +528,14 @@ void nilSysTimerHandlerI(void) {
     /* No tick event needed.*/
     port_timer_reset_alarm();
   }
+
+#if NIL_CFG_USE_VIRTUAL_TIMERS
+  while (fired != NULL) {
+    vtp = fired;
+    fired = vtp->fnext;
+    vtp->func(vtp->par);
+  }
+#endif
 #endif
 }
 
@@ -220,11 +561,36 @@ thread_ref_t nilSchReadyI(thread_ref_t tr, msg_t msg) {
   nilDbgAssert(nil.next <= nil.current,
                "nilSchReadyI(), #3", "priority ordering");
 
+#if NIL_CFG_TIMEDELTA == 0
+  nil_tmo_remove(tr);
+#endif
+  NIL_TRACE_EVENT(NIL_TRACE_READY, tr, msg);
   tr->u1.msg = msg;
   tr->state = NIL_THD_READY;
   tr->timeout = 0;
+#if NIL_CFG_USE_READY_MASK
+  nil.readymask |= NIL_THD_MASK(tr);
+#endif
+#if NIL_CFG_USE_MUTEXES
+  {
+    /* The thread runs at the priority of the highest priority thread,
+       itself or a mutex waiter, that resolves to it.*/
+    thdmask_t mask = nil.readymask & (NIL_THD_MASK(nil.next) - 1);
+    thread_ref_t p;
+
+    while (mask) {
+      p = nil_mask_first(mask);
+      if (nil_mtx_resolve(p) == tr) {
+        nil.next = p;
+        break;
+      }
+      mask &= ~NIL_THD_MASK(p);
+    }
+  }
+#else /* !NIL_CFG_USE_MUTEXES */
   if (tr < nil.next)
     nil.next = tr;
+#endif /* !NIL_CFG_USE_MUTEXES */
   return tr;
 }
 
@@ -235,7 +601,11 @@ thread_ref_t nilSchReadyI(thread_ref_t tr, msg_t msg) {
  */
 void nilSchRescheduleS() {
   thread_ref_t otr = nil.current;
+#if NIL_CFG_USE_MUTEXES
+  thread_ref_t ntr = nil_mtx_resolve(nil.next);
+#else /* !NIL_CFG_USE_MUTEXES */
   thread_ref_t ntr = nil.next;
+#endif /* !NIL_CFG_USE_MUTEXES */
 
   if (ntr != otr) {
     nil.current = ntr;
@@ -248,6 +618,10 @@ void nilSchRescheduleS() {
       NIL_CFG_IDLE_LEAVE_HOOK();
     }
 #endif
+    NIL_STACK_CHECK(otr);
+    NIL_CPU_USAGE_UPDATE(otr);
+    NIL_TRACE_EVENT(NIL_TRACE_SWITCH, ntr,
+                    ((otr - nil.threads) << 8) | otr->state);
     port_switch(ntr, otr);
   }
 }
@@ -284,48 +658,32 @@ msg_t nilSchGoSleepTimeoutS(tstate_t newstate, systime_t timeout) {
   otr->state = newstate;
 
 #if NIL_CFG_TIMEDELTA > 0
-  if (timeout != TIME_INFINITE) {
-    systime_t time;
-
-    /* TIMEDELTA makes sure to have enough time to reprogram the timer
-       before the free-running timer counter reaches the selected timeout.*/
-    if (timeout < NIL_CFG_TIMEDELTA)
-      timeout = NIL_CFG_TIMEDELTA;
-
-    time = nilTimeNowI() + timeout;
-    if (nilTimeIsWithin(time, nil.lasttime, nil.nexttime)) {
-      port_timer_set_alarm(time);
-      nil.nexttime = time;
-    }
-
-    /* Timeout settings.*/
-    otr->timeout = time - nil.lasttime;
-  }
+  /* Timeout settings.*/
+  if (timeout != TIME_INFINITE)
+    otr->timeout = nil_alarm_insert(timeout);
 #else
 
   /* Timeout settings.*/
-  otr->timeout = timeout;
+  if (timeout != TIME_INFINITE)
+    nil_tmo_insert(otr, timeout);
 #endif
 
+#if NIL_CFG_USE_MUTEXES
+  /* A thread waiting on a mutex keeps its ready bit so the owner inherits
+     its priority.*/
+  if (newstate != NIL_THD_WTMTX)
+    nil.readymask &= ~NIL_THD_MASK(otr);
+  nil.next = nil_sch_first();
+  ntr = nil_mtx_resolve(nil.next);
+#elif NIL_CFG_USE_READY_MASK
+  /* The highest priority ready thread is the lowest bit in the ready mask,
+     the idle thread bit is always set.*/
+  nil.readymask &= ~NIL_THD_MASK(otr);
+  ntr = nil_mask_first(nil.readymask);
+#else /* !NIL_CFG_USE_READY_MASK */
   /* Scanning the whole threads array.*/
   ntr = nil.threads;
-  while (true) {
-    /* Is this thread ready to execute?*/
-    if (NIL_THD_IS_READY(ntr)) {
-      nil.current = nil.next = ntr;
-#if defined(NIL_CFG_IDLE_ENTER_HOOK)
-#if WHG_MOD
-      if (ntr == nil.idlep) {
-#else  /* WHG_MOD */
-      if (ntr == &nil.threads[NIL_CFG_NUM_THREADS]) {
-#endif  /* WHG_MOD */
-        NIL_CFG_IDLE_ENTER_HOOK();
-      }
-#endif
-      port_switch(ntr, otr);
-      return nil.current->u1.msg;
-    }
-
+  while (!NIL_THD_IS_READY(ntr)) {
     /* Points to the next thread in lowering priority order.*/
     ntr++;
 #if WHG_MOD
@@ -336,6 +694,30 @@ msg_t nilSchGoSleepTimeoutS(tstate_t newstate, systime_t timeout) {
                  "nilSchGoSleepTimeoutS(), #2", "pointer out of range");
 #endif  /* WHG_MOD */
   }
+#endif /* !NIL_CFG_USE_READY_MASK */
+  nilDbgAssert(NIL_THD_IS_READY(ntr),
+               "nilSchGoSleepTimeoutS(), #3", "not ready");
+
+#if NIL_CFG_USE_MUTEXES
+  nil.current = ntr;
+#else /* !NIL_CFG_USE_MUTEXES */
+  nil.current = nil.next = ntr;
+#endif /* !NIL_CFG_USE_MUTEXES */
+#if defined(NIL_CFG_IDLE_ENTER_HOOK)
+#if WHG_MOD
+  if (ntr == nil.idlep) {
+#else  /* WHG_MOD */
+  if (ntr == &nil.threads[NIL_CFG_NUM_THREADS]) {
+#endif  /* WHG_MOD */
+    NIL_CFG_IDLE_ENTER_HOOK();
+  }
+#endif
+  NIL_STACK_CHECK(otr);
+  NIL_CPU_USAGE_UPDATE(otr);
+  NIL_TRACE_EVENT(NIL_TRACE_SWITCH, ntr,
+                  ((otr - nil.threads) << 8) | otr->state);
+  port_switch(ntr, otr);
+  return nil.current->u1.msg;
 }
 
 /**
@@ -508,7 +890,11 @@ msg_t nilSemWaitTimeoutS(semaphore_t *sp, systime_t timeout) {
     if (TIME_IMMEDIATE == timeout)
       return NIL_MSG_TMO;
     sp->cnt = cnt - 1;
+#if NIL_CFG_USE_READY_MASK
+    sp->waiters |= NIL_THD_MASK(nil.current);
+#endif
     nil.current->u1.semp = sp;
+    NIL_TRACE_EVENT(NIL_TRACE_SEM_WAIT, nil.current, (uint16_t)(size_t)sp);
     return nilSchGoSleepTimeoutS(NIL_THD_WTSEM, timeout);
   }
   sp->cnt = cnt - 1;
@@ -543,7 +929,18 @@ void nilSemSignal(semaphore_t *sp) {
  */
 void nilSemSignalI(semaphore_t *sp) {
 
+  NIL_TRACE_EVENT(NIL_TRACE_SEM_SIGNAL, nil.current, (uint16_t)(size_t)sp);
   if (++sp->cnt <= 0) {
+#if NIL_CFG_USE_READY_MASK
+    /* The highest priority waiting thread is released.*/
+    thread_ref_t tr = nil_mask_first(sp->waiters);
+
+    nilDbgAssert(NIL_THD_IS_WTSEM(tr) && (tr->u1.semp == sp),
+                 "nilSemSignalI(), #1", "not waiting");
+
+    sp->waiters &= ~NIL_THD_MASK(tr);
+    nilSchReadyI(tr, NIL_MSG_OK);
+#else /* !NIL_CFG_USE_READY_MASK */
     thread_ref_t tr = nil.threads;
     while (true) {
       /* Is this thread waiting on this semaphore?*/
@@ -557,6 +954,7 @@ void nilSemSignalI(semaphore_t *sp) {
       }
       tr++;
     }
+#endif /* !NIL_CFG_USE_READY_MASK */
   }
 }
 
@@ -598,6 +996,22 @@ void nilSemReset(semaphore_t *sp, cnt_t n) {
  */
 void nilSemResetI(semaphore_t *sp, cnt_t n) {
   thread_ref_t tr;
+#if NIL_CFG_USE_READY_MASK
+  thdmask_t waiters;
+
+  waiters = sp->waiters;
+  sp->waiters = 0;
+  sp->cnt = n;
+  while (waiters) {
+    tr = nil_mask_first(waiters);
+
+    nilDbgAssert(NIL_THD_IS_WTSEM(tr) && (tr->u1.semp == sp),
+                 "nilSemResetI(), #1", "not waiting");
+
+    waiters &= ~NIL_THD_MASK(tr);
+    nilSchReadyI(tr, NIL_MSG_RST);
+  }
+#else /* !NIL_CFG_USE_READY_MASK */
   cnt_t cnt;
 
   cnt = sp->cnt;
@@ -615,6 +1029,1112 @@ void nilSemResetI(semaphore_t *sp, cnt_t n) {
     }
     tr++;
   }
+#endif /* !NIL_CFG_USE_READY_MASK */
+}
+
+#if NIL_CFG_USE_EVENTS || defined(__DOXYGEN__)
+/**
+ * @brief   Waits for event flags.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to wait for, must not be zero
+ * @param[in] newstate  @p NIL_THD_WTANY or @p NIL_THD_WTALL
+ * @param[in] timeout   the number of ticks before the operation timeouts
+ * @return              The event flags that released the thread.
+ * @retval 0            if a timeout occurred.
+ */
+static eventmask_t nil_evt_wait(event_flags_t *efp, eventmask_t mask,
+                                tstate_t newstate, systime_t timeout) {
+  eventmask_t m;
+  msg_t msg;
+
+  nilDbgAssert(mask != 0, "nil_evt_wait(), #1", "zero mask");
+
+  m = efp->flags & mask;
+  if ((newstate == NIL_THD_WTANY) ? (m != 0) : (m == mask)) {
+    efp->flags &= ~m;
+    return m;
+  }
+  if (TIME_IMMEDIATE == timeout)
+    return 0;
+  efp->waiters |= NIL_THD_MASK(nil.current);
+  nil.current->u1.efp = efp;
+  nil.current->ewmask = mask;
+  msg = nilSchGoSleepTimeoutS(newstate, timeout);
+  return msg == NIL_MSG_TMO ? 0 : (eventmask_t)msg;
+}
+
+/**
+ * @brief   Waits for any of the specified event flags with timeout
+ *          specification.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to wait for, must not be zero
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The event flags in @p mask that were set, these
+ *                      flags are cleared in the object.
+ * @retval 0            if none of the flags was set within the specified
+ *                      timeout.
+ *
+ * @api
+ */
+eventmask_t nilEvtWaitAnyTimeout(event_flags_t *efp, eventmask_t mask,
+                                 systime_t timeout) {
+  eventmask_t m;
+
+  nilSysLock();
+  m = nilEvtWaitAnyTimeoutS(efp, mask, timeout);
+  nilSysUnlock();
+  return m;
+}
+
+/**
+ * @brief   Waits for any of the specified event flags with timeout
+ *          specification.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to wait for, must not be zero
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The event flags in @p mask that were set, these
+ *                      flags are cleared in the object.
+ * @retval 0            if none of the flags was set within the specified
+ *                      timeout.
+ *
+ * @sclass
+ */
+eventmask_t nilEvtWaitAnyTimeoutS(event_flags_t *efp, eventmask_t mask,
+                                  systime_t timeout) {
+
+  return nil_evt_wait(efp, mask, NIL_THD_WTANY, timeout);
+}
+
+/**
+ * @brief   Waits for all of the specified event flags with timeout
+ *          specification.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to wait for, must not be zero
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The event flags in @p mask, these flags are
+ *                      cleared in the object.
+ * @retval 0            if all of the flags were not set within the
+ *                      specified timeout.
+ *
+ * @api
+ */
+eventmask_t nilEvtWaitAllTimeout(event_flags_t *efp, eventmask_t mask,
+                                 systime_t timeout) {
+  eventmask_t m;
+
+  nilSysLock();
+  m = nilEvtWaitAllTimeoutS(efp, mask, timeout);
+  nilSysUnlock();
+  return m;
+}
+
+/**
+ * @brief   Waits for all of the specified event flags with timeout
+ *          specification.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to wait for, must not be zero
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The event flags in @p mask, these flags are
+ *                      cleared in the object.
+ * @retval 0            if all of the flags were not set within the
+ *                      specified timeout.
+ *
+ * @sclass
+ */
+eventmask_t nilEvtWaitAllTimeoutS(event_flags_t *efp, eventmask_t mask,
+                                  systime_t timeout) {
+
+  return nil_evt_wait(efp, mask, NIL_THD_WTALL, timeout);
+}
+
+/**
+ * @brief   Sets event flags.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to set
+ *
+ * @api
+ */
+void nilEvtSignal(event_flags_t *efp, eventmask_t mask) {
+
+  nilSysLock();
+  nilEvtSignalI(efp, mask);
+  nilSchRescheduleS();
+  nilSysUnlock();
+}
+
+/**
+ * @brief   Sets event flags.
+ * @details Waiting threads are checked in priority order so a higher
+ *          priority thread consumes flags before a lower priority thread
+ *          waiting for the same flags.  Flags not consumed by a waiting
+ *          thread remain set.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to set
+ *
+ * @iclass
+ */
+void nilEvtSignalI(event_flags_t *efp, eventmask_t mask) {
+  thread_ref_t tr;
+  thdmask_t waiters;
+  eventmask_t m;
+
+  efp->flags |= mask;
+  waiters = efp->waiters;
+  while (waiters) {
+    tr = nil_mask_first(waiters);
+
+    nilDbgAssert((NIL_THD_IS_WTANY(tr) || NIL_THD_IS_WTALL(tr)) &&
+                 (tr->u1.efp == efp),
+                 "nilEvtSignalI(), #1", "not waiting");
+
+    waiters &= ~NIL_THD_MASK(tr);
+    m = efp->flags & tr->ewmask;
+    if (NIL_THD_IS_WTANY(tr) ? (m != 0) : (m == tr->ewmask)) {
+      efp->flags &= ~m;
+      efp->waiters &= ~NIL_THD_MASK(tr);
+      nilSchReadyI(tr, (msg_t)m);
+    }
+  }
+}
+#endif /* NIL_CFG_USE_EVENTS */
+
+#if NIL_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+/**
+ * @brief   Locks a mutex with timeout specification.
+ * @details If the mutex is owned by another thread, the owner runs at the
+ *          priority of the invoking thread, if higher, until it unlocks
+ *          the mutex.
+ * @note    Mutexes are not recursive, the owner must not lock the mutex
+ *          again.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if the mutex has been locked.
+ * @retval NIL_MSG_TMO  if the mutex has not been unlocked within the
+ *                      specified timeout.
+ *
+ * @api
+ */
+msg_t nilMtxLockTimeout(mutex_t *mp, systime_t timeout) {
+  msg_t msg;
+
+  nilSysLock();
+  msg = nilMtxLockTimeoutS(mp, timeout);
+  nilSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Locks a mutex with timeout specification.
+ * @details If the mutex is owned by another thread, the owner runs at the
+ *          priority of the invoking thread, if higher, until it unlocks
+ *          the mutex.
+ * @note    Mutexes are not recursive, the owner must not lock the mutex
+ *          again.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if the mutex has been locked.
+ * @retval NIL_MSG_TMO  if the mutex has not been unlocked within the
+ *                      specified timeout.
+ *
+ * @sclass
+ */
+msg_t nilMtxLockTimeoutS(mutex_t *mp, systime_t timeout) {
+
+  if (mp->owner == NULL) {
+    mp->owner = nil.current;
+    return NIL_MSG_OK;
+  }
+  nilDbgAssert(mp->owner != nil.current,
+               "nilMtxLockTimeoutS(), #1", "already owned");
+
+  if (TIME_IMMEDIATE == timeout)
+    return NIL_MSG_TMO;
+  mp->waiters |= NIL_THD_MASK(nil.current);
+  nil.current->u1.mtxp = mp;
+  return nilSchGoSleepTimeoutS(NIL_THD_WTMTX, timeout);
+}
+
+/**
+ * @brief   Unlocks a mutex.
+ * @details Ownership passes to the highest priority waiting thread, if
+ *          any, and the invoking thread returns to its own priority.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ *
+ * @api
+ */
+void nilMtxUnlock(mutex_t *mp) {
+
+  nilSysLock();
+  nilMtxUnlockS(mp);
+  nilSchRescheduleS();
+  nilSysUnlock();
+}
+
+/**
+ * @brief   Unlocks a mutex.
+ * @details Ownership passes to the highest priority waiting thread, if
+ *          any, and the invoking thread returns to its own priority.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ *
+ * @sclass
+ */
+void nilMtxUnlockS(mutex_t *mp) {
+
+  nilDbgAssert(mp->owner == nil.current,
+               "nilMtxUnlockS(), #1", "not owner");
+
+  if (mp->waiters) {
+    thread_ref_t tr = nil_mask_first(mp->waiters);
+
+    nilDbgAssert(NIL_THD_IS_WTMTX(tr) && (tr->u1.mtxp == mp),
+                 "nilMtxUnlockS(), #2", "not waiting");
+
+    mp->waiters &= ~NIL_THD_MASK(tr);
+    mp->owner = tr;
+    nilSchReadyI(tr, NIL_MSG_OK);
+  }
+  else {
+    mp->owner = NULL;
+  }
+  /* The inherited priority, if any, is dropped.*/
+  nil.next = nil_sch_first();
+}
+#endif /* NIL_CFG_USE_MUTEXES */
+
+/**
+ * @brief   Initializes a memory pool with an array of blocks.
+ * @note    The block size must be at least the size of a pointer and
+ *          should be a multiple of the alignment required by the objects
+ *          stored in the blocks.
+ *
+ * @param[out] mp       pointer to a @p memory_pool_t structure
+ * @param[in] p         pointer to the array of blocks
+ * @param[in] size      the size of a block in bytes
+ * @param[in] n         number of blocks in the array
+ *
+ * @init
+ */
+void nilPoolInit(memory_pool_t *mp, void *p, size_t size, cnt_t n) {
+  uint8_t *bp = (uint8_t*)p;
+
+  nilDbgAssert((size >= sizeof(pool_header_t)) && (n > 0),
+               "nilPoolInit(), #1", "invalid size");
+
+  mp->next = NULL;
+  nilSemInit(&mp->sem, n);
+  mp->minfree = n;
+  while (n--) {
+    ((pool_header_t*)bp)->next = mp->next;
+    mp->next = (pool_header_t*)bp;
+    bp += size;
+  }
+}
+
+/**
+ * @brief   Removes the first free block from a memory pool.
+ * @details The semaphore counter has already been decremented for the
+ *          block.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @return              The pointer to the block.
+ */
+static void *nil_pool_get(memory_pool_t *mp) {
+  pool_header_t *bp = mp->next;
+  cnt_t n = mp->sem.cnt < 0 ? 0 : mp->sem.cnt;
+
+  nilDbgAssert(bp != NULL, "nil_pool_get(), #1", "empty pool");
+
+  mp->next = bp->next;
+  if (n < mp->minfree)
+    mp->minfree = n;
+  return bp;
+}
+
+/**
+ * @brief   Allocates a block from a memory pool with timeout
+ *          specification.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated block.
+ * @retval NULL         if no block was freed within the specified
+ *                      timeout.
+ *
+ * @api
+ */
+void *nilPoolAllocTimeout(memory_pool_t *mp, systime_t timeout) {
+  void *objp;
+
+  nilSysLock();
+  objp = nilPoolAllocTimeoutS(mp, timeout);
+  nilSysUnlock();
+  return objp;
+}
+
+/**
+ * @brief   Allocates a block from a memory pool with timeout
+ *          specification.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The pointer to the allocated block.
+ * @retval NULL         if no block was freed within the specified
+ *                      timeout.
+ *
+ * @sclass
+ */
+void *nilPoolAllocTimeoutS(memory_pool_t *mp, systime_t timeout) {
+
+  if (nilSemWaitTimeoutS(&mp->sem, timeout) != NIL_MSG_OK)
+    return NULL;
+  return nil_pool_get(mp);
+}
+
+/**
+ * @brief   Allocates a block from a memory pool.
+ * @details This variant is non-blocking, the function returns NULL if
+ *          the pool is empty.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @return              The pointer to the allocated block.
+ * @retval NULL         if the pool is empty.
+ *
+ * @iclass
+ */
+void *nilPoolAllocI(memory_pool_t *mp) {
+
+  if (mp->sem.cnt <= 0)
+    return NULL;
+  mp->sem.cnt--;
+  return nil_pool_get(mp);
+}
+
+/**
+ * @brief   Releases a block into a memory pool.
+ * @details The highest priority thread waiting for a block, if any, is
+ *          released.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] objp      the pointer to the block to be released
+ *
+ * @api
+ */
+void nilPoolFree(memory_pool_t *mp, void *objp) {
+
+  nilSysLock();
+  nilPoolFreeI(mp, objp);
+  nilSchRescheduleS();
+  nilSysUnlock();
+}
+
+/**
+ * @brief   Releases a block into a memory pool.
+ * @details The highest priority thread waiting for a block, if any, is
+ *          released.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @param[in] objp      the pointer to the block to be released
+ *
+ * @iclass
+ */
+void nilPoolFreeI(memory_pool_t *mp, void *objp) {
+  pool_header_t *bp = (pool_header_t*)objp;
+
+  bp->next = mp->next;
+  mp->next = bp;
+  nilSemSignalI(&mp->sem);
+}
+
+/**
+ * @brief   Initializes a mailbox.
+ *
+ * @param[out] mbp      pointer to a @p mailbox_t structure
+ * @param[in] buf       pointer to the messages buffer as an array of
+ *                      @p msg_t
+ * @param[in] n         number of elements in the buffer array
+ *
+ * @init
+ */
+void nilMBInit(mailbox_t *mbp, msg_t *buf, cnt_t n) {
+
+  nilDbgAssert(n > 0, "nilMBInit(), #1", "invalid size");
+
+  mbp->buffer = mbp->rdptr = mbp->wrptr = buf;
+  mbp->top = &buf[n];
+  nilSemInit(&mbp->emptysem, n);
+  nilSemInit(&mbp->fullsem, 0);
+}
+
+/**
+ * @brief   Resets a mailbox.
+ * @details All the waiting threads are resumed with status @p NIL_MSG_RST
+ *          and the pending messages are lost.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ *
+ * @api
+ */
+void nilMBReset(mailbox_t *mbp) {
+
+  nilSysLock();
+  nilMBResetI(mbp);
+  nilSchRescheduleS();
+  nilSysUnlock();
+}
+
+/**
+ * @brief   Resets a mailbox.
+ * @details All the waiting threads are resumed with status @p NIL_MSG_RST
+ *          and the pending messages are lost.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ *
+ * @iclass
+ */
+void nilMBResetI(mailbox_t *mbp) {
+
+  mbp->wrptr = mbp->rdptr = mbp->buffer;
+  nilSemResetI(&mbp->emptysem, mbp->top - mbp->buffer);
+  nilSemResetI(&mbp->fullsem, 0);
+}
+
+/**
+ * @brief   Stores a message at the write pointer.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ */
+static void nil_mb_put(mailbox_t *mbp, msg_t msg) {
+
+  *mbp->wrptr++ = msg;
+  if (mbp->wrptr >= mbp->top)
+    mbp->wrptr = mbp->buffer;
+  nilSemSignalI(&mbp->fullsem);
+}
+
+/**
+ * @brief   Stores a message ahead of the read pointer.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ */
+static void nil_mb_put_ahead(mailbox_t *mbp, msg_t msg) {
+
+  if (--mbp->rdptr < mbp->buffer)
+    mbp->rdptr = mbp->top - 1;
+  *mbp->rdptr = msg;
+  nilSemSignalI(&mbp->fullsem);
+}
+
+/**
+ * @brief   Removes the message at the read pointer.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ */
+static void nil_mb_get(mailbox_t *mbp, msg_t *msgp) {
+
+  *msgp = *mbp->rdptr++;
+  if (mbp->rdptr >= mbp->top)
+    mbp->rdptr = mbp->buffer;
+  nilSemSignalI(&mbp->emptysem);
+}
+
+/**
+ * @brief   Posts a message into a mailbox.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ * @retval NIL_MSG_TMO  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t nilMBPostTimeout(mailbox_t *mbp, msg_t msg, systime_t timeout) {
+  msg_t rdymsg;
+
+  nilSysLock();
+  rdymsg = nilMBPostTimeoutS(mbp, msg, timeout);
+  nilSysUnlock();
+  return rdymsg;
+}
+
+/**
+ * @brief   Posts a message into a mailbox.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ * @retval NIL_MSG_TMO  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t nilMBPostTimeoutS(mailbox_t *mbp, msg_t msg, systime_t timeout) {
+  msg_t rdymsg;
+
+  rdymsg = nilSemWaitTimeoutS(&mbp->emptysem, timeout);
+  if (rdymsg == NIL_MSG_OK) {
+    nil_mb_put(mbp, msg);
+    nilSchRescheduleS();
+  }
+  return rdymsg;
+}
+
+/**
+ * @brief   Posts a message into a mailbox.
+ * @details This variant is non-blocking, the function returns a timeout
+ *          condition if the mailbox is full.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_TMO  if the mailbox is full.
+ *
+ * @iclass
+ */
+msg_t nilMBPostI(mailbox_t *mbp, msg_t msg) {
+
+  if (mbp->emptysem.cnt <= 0)
+    return NIL_MSG_TMO;
+  mbp->emptysem.cnt--;
+  nil_mb_put(mbp, msg);
+  return NIL_MSG_OK;
+}
+
+/**
+ * @brief   Posts a high priority message into a mailbox.
+ * @details The message is inserted ahead of the pending messages so it
+ *          is the next message fetched.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ * @retval NIL_MSG_TMO  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t nilMBPostAheadTimeout(mailbox_t *mbp, msg_t msg, systime_t timeout) {
+  msg_t rdymsg;
+
+  nilSysLock();
+  rdymsg = nilMBPostAheadTimeoutS(mbp, msg, timeout);
+  nilSysUnlock();
+  return rdymsg;
+}
+
+/**
+ * @brief   Posts a high priority message into a mailbox.
+ * @details The message is inserted ahead of the pending messages so it
+ *          is the next message fetched.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ * @retval NIL_MSG_TMO  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t nilMBPostAheadTimeoutS(mailbox_t *mbp, msg_t msg, systime_t timeout) {
+  msg_t rdymsg;
+
+  rdymsg = nilSemWaitTimeoutS(&mbp->emptysem, timeout);
+  if (rdymsg == NIL_MSG_OK) {
+    nil_mb_put_ahead(mbp, msg);
+    nilSchRescheduleS();
+  }
+  return rdymsg;
+}
+
+/**
+ * @brief   Posts a high priority message into a mailbox.
+ * @details The message is inserted ahead of the pending messages so it
+ *          is the next message fetched.
+ * @details This variant is non-blocking, the function returns a timeout
+ *          condition if the mailbox is full.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_TMO  if the mailbox is full.
+ *
+ * @iclass
+ */
+msg_t nilMBPostAheadI(mailbox_t *mbp, msg_t msg) {
+
+  if (mbp->emptysem.cnt <= 0)
+    return NIL_MSG_TMO;
+  mbp->emptysem.cnt--;
+  nil_mb_put_ahead(mbp, msg);
+  return NIL_MSG_OK;
+}
+
+/**
+ * @brief   Retrieves a message from a mailbox.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly fetched.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ * @retval NIL_MSG_TMO  if the operation has timed out.
+ *
+ * @api
+ */
+msg_t nilMBFetchTimeout(mailbox_t *mbp, msg_t *msgp, systime_t timeout) {
+  msg_t rdymsg;
+
+  nilSysLock();
+  rdymsg = nilMBFetchTimeoutS(mbp, msgp, timeout);
+  nilSysUnlock();
+  return rdymsg;
+}
+
+/**
+ * @brief   Retrieves a message from a mailbox.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @param[in] timeout   the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly fetched.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ * @retval NIL_MSG_TMO  if the operation has timed out.
+ *
+ * @sclass
+ */
+msg_t nilMBFetchTimeoutS(mailbox_t *mbp, msg_t *msgp, systime_t timeout) {
+  msg_t rdymsg;
+
+  rdymsg = nilSemWaitTimeoutS(&mbp->fullsem, timeout);
+  if (rdymsg == NIL_MSG_OK) {
+    nil_mb_get(mbp, msgp);
+    nilSchRescheduleS();
+  }
+  return rdymsg;
+}
+
+/**
+ * @brief   Retrieves a message from a mailbox.
+ * @details This variant is non-blocking, the function returns a timeout
+ *          condition if the mailbox is empty.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly fetched.
+ * @retval NIL_MSG_TMO  if the mailbox is empty.
+ *
+ * @iclass
+ */
+msg_t nilMBFetchI(mailbox_t *mbp, msg_t *msgp) {
+
+  if (mbp->fullsem.cnt <= 0)
+    return NIL_MSG_TMO;
+  mbp->fullsem.cnt--;
+  nil_mb_get(mbp, msgp);
+  return NIL_MSG_OK;
+}
+
+#if NIL_CFG_USE_VIRTUAL_TIMERS || defined(__DOXYGEN__)
+/**
+ * @brief   Arms a virtual timer.
+ * @details The timer is reset first if it is armed.
+ *
+ * @param[in] vtp       pointer to a @p virtual_timer_t structure
+ * @param[in] delay     the number of ticks before the first callback,
+ *                      must not be zero
+ * @param[in] period    the number of ticks between later callbacks or
+ *                      zero for a one-shot timer
+ * @param[in] func      the callback function
+ * @param[in] par       the callback parameter
+ *
+ * @api
+ */
+void nilVTSet(virtual_timer_t *vtp, systime_t delay, systime_t period,
+              vtfunc_t func, void *par) {
+
+  nilSysLock();
+  nilVTResetI(vtp);
+  nilVTSetI(vtp, delay, period, func, par);
+  nilSysUnlock();
+}
+
+/**
+ * @brief   Arms a virtual timer.
+ * @details The callback is invoked by @p nilSysTimerHandlerI() with the
+ *          kernel locked after @p delay ticks, then every @p period ticks
+ *          if @p period is not zero.  Periodic callbacks do not drift, the
+ *          next expiration is computed from the previous one.
+ * @note    The callback runs in an ISR so it must only call I-class
+ *          functions.  It can arm or reset any timer, itself included.
+ * @note    In tick-less mode delays and periods below @p NIL_CFG_TIMEDELTA
+ *          are rounded up.
+ *
+ * @param[in] vtp       pointer to a @p virtual_timer_t structure, the
+ *                      timer must not be armed
+ * @param[in] delay     the number of ticks before the first callback,
+ *                      must not be zero
+ * @param[in] period    the number of ticks between later callbacks or
+ *                      zero for a one-shot timer
+ * @param[in] func      the callback function
+ * @param[in] par       the callback parameter
+ *
+ * @iclass
+ */
+void nilVTSetI(virtual_timer_t *vtp, systime_t delay, systime_t period,
+               vtfunc_t func, void *par) {
+
+  nilDbgAssert((delay != 0) && (func != NULL),
+               "nilVTSetI(), #1", "invalid parameter");
+  nilDbgAssert(!nilVTIsArmedI(vtp),
+               "nilVTSetI(), #2", "already armed");
+
+  vtp->func = func;
+  vtp->par = par;
+#if NIL_CFG_TIMEDELTA > 0
+  if ((period != 0) && (period < NIL_CFG_TIMEDELTA))
+    period = NIL_CFG_TIMEDELTA;
+  nilDbgAssert(period <= NIL_MAX_TIMEOUT,
+               "nilVTSetI(), #3", "too long");
+  vtp->period = period;
+  vtp->timeout = nil_alarm_insert(delay);
+  vtp->next = nil.vtlist;
+  nil.vtlist = vtp;
+#else
+  vtp->period = period;
+  nil_vt_insert(vtp, delay);
+#endif
+}
+
+/**
+ * @brief   Disarms a virtual timer.
+ * @details Does nothing if the timer is not armed.
+ *
+ * @param[in] vtp       pointer to a @p virtual_timer_t structure
+ *
+ * @api
+ */
+void nilVTReset(virtual_timer_t *vtp) {
+
+  nilSysLock();
+  nilVTResetI(vtp);
+  nilSysUnlock();
+}
+
+/**
+ * @brief   Disarms a virtual timer.
+ * @details Does nothing if the timer is not armed.
+ * @note    In tick-less mode a timer that expires in the same tick event
+ *          as the caller's timer has already expired, its callback still
+ *          runs in this tick event.
+ *
+ * @param[in] vtp       pointer to a @p virtual_timer_t structure
+ *
+ * @iclass
+ */
+void nilVTResetI(virtual_timer_t *vtp) {
+
+#if NIL_CFG_TIMEDELTA > 0
+  virtual_timer_t **vtpp;
+
+  if (!nilVTIsArmedI(vtp))
+    return;
+  for (vtpp = &nil.vtlist; *vtpp != NULL; vtpp = &(*vtpp)->next) {
+    if (*vtpp == vtp) {
+      *vtpp = vtp->next;
+      break;
+    }
+  }
+  /* The alarm is left as is, a tick event with nothing to do is
+     harmless.*/
+  vtp->timeout = 0;
+#else
+  nil_vt_remove(vtp);
+#endif
+}
+#endif /* NIL_CFG_USE_VIRTUAL_TIMERS */
+
+#if NIL_CFG_TRACE || defined(__DOXYGEN__)
+/**
+ * @brief   Records an event in the trace buffer.
+ * @details The oldest event is overwritten when the buffer is full.
+ *
+ * @param[in] type      the event type
+ * @param[in] tr        reference to the @p thread_t object
+ * @param[in] arg       the event argument
+ *
+ * @iclass
+ */
+void nilTraceEventI(uint8_t type, thread_ref_t tr, uint16_t arg) {
+  nil_trace_event_t *ep;
+
+  if (nil.trace.suspended)
+    return;
+  ep = &nil.trace.buffer[nil.trace.next];
+  ep->type = type;
+  ep->thd = tr - nil.threads;
+  ep->time = port_time_stamp();
+  ep->arg = arg;
+  if (++nil.trace.next >= NIL_CFG_TRACE_SIZE) {
+    nil.trace.next = 0;
+    nil.trace.full = true;
+  }
+}
+#endif /* NIL_CFG_TRACE */
+
+#if NIL_CFG_CPU_USAGE || defined(__DOXYGEN__)
+/**
+ * @brief   Adds the time since the last update to a thread's run time.
+ * @details Must be called for the running thread at least once per
+ *          time stamp period, 65536 counts, for correct results.
+ *
+ * @param[in] tr        reference to the running @p thread_t object
+ *
+ * @iclass
+ */
+void nilCpuUsageUpdateI(thread_ref_t tr) {
+  uint16_t t = port_time_stamp();
+
+  tr->cputime += (uint16_t)(t - nil.cpustamp);
+  nil.cpustamp = t;
+}
+
+/**
+ * @brief   Saves the run time of all threads and restarts the measurement.
+ * @details Each thread's run time is saved in @p cpusnap, shifted right
+ *          the same amount for all threads so the sum of the saved values
+ *          fits in 16 bits.  A thread's share of the CPU is its
+ *          @p cpusnap divided by the sum.
+ *
+ * @sclass
+ */
+void nilCpuUsageSnapshotS(void) {
+  thread_ref_t tr;
+  uint32_t total = 0;
+  uint8_t shift = 0;
+
+  nilCpuUsageUpdateI(nil.current);
+  for (tr = nil.threads;
+#if WHG_MOD
+       tr <= nil.idlep;
+#else  /* WHG_MOD */
+       tr <= &nil.threads[NIL_CFG_NUM_THREADS];
+#endif  /* WHG_MOD */
+       tr++) {
+    total += tr->cputime;
+  }
+  while (total > 0XFFFF) {
+    total >>= 1;
+    shift++;
+  }
+  for (tr = nil.threads;
+#if WHG_MOD
+       tr <= nil.idlep;
+#else  /* WHG_MOD */
+       tr <= &nil.threads[NIL_CFG_NUM_THREADS];
+#endif  /* WHG_MOD */
+       tr++) {
+    tr->cpusnap = tr->cputime >> shift;
+    tr->cputime = 0;
+  }
+}
+#endif /* NIL_CFG_CPU_USAGE */
+
+#if NIL_CFG_LOCK_PROFILE || defined(__DOXYGEN__)
+/**
+ * @brief   Starts timing a lock section.
+ * @details The return address is the lock address, it identifies the
+ *          code that disabled interrupts.
+ * @note    On AVR the address is a word address, double it to find the
+ *          code in the avr-objdump listing.
+ *
+ * @special
+ */
+__attribute__((noinline)) void nilLockProfileStartI(void) {
+
+  nil.lockprof.site = __builtin_return_address(0);
+  nil.lockprof.start = port_time_stamp();
+}
+
+/**
+ * @brief   Stops timing a lock section.
+ * @details The section length is added to the histogram and the longest
+ *          section is updated.  An unlock without a timed lock is
+ *          ignored.
+ *
+ * @special
+ */
+void nilLockProfileStopI(void) {
+  uint16_t d = port_time_stamp() - nil.lockprof.start;
+  uint8_t i = 0;
+
+  if (nil.lockprof.site == NULL)
+    return;
+  if (d > nil.lockprof.max) {
+    nil.lockprof.max = d;
+    nil.lockprof.maxsite = nil.lockprof.site;
+  }
+  while ((d != 0) && (i < NIL_CFG_LOCK_PROFILE_BINS - 1)) {
+    d >>= 1;
+    i++;
+  }
+  if (nil.lockprof.hist[i] != (uint32_t)-1)
+    nil.lockprof.hist[i]++;
+  nil.lockprof.site = NULL;
+}
+#endif /* NIL_CFG_LOCK_PROFILE */
+
+#if NIL_CFG_STACK_MONITOR || defined(__DOXYGEN__)
+/**
+ * @brief   Checks @p NIL_CFG_STACK_MONITOR_CHUNK bytes of a thread stack.
+ * @details Threads are scanned in turn.  A scan starts at the last unused
+ *          stack count and moves down to the bottom of the working area,
+ *          each byte that is not the 0X55 fill lowers the count.  Stacks
+ *          grow down so new use is usually found by the first step.  A
+ *          complete scan gives the same count as @p nilUnusedStack().
+ * @note    Called by the idle enter hook, see @p NIL_STACK_MONITOR_STEP().
+ *
+ * @sclass
+ */
+void nilStackMonitorStepS(void) {
+  thread_ref_t tr = nil_sm_thread;
+  uint8_t *bottom = (uint8_t *)nil_thd_configs[tr - nil.threads].wap +
+                    NIL_STACK_GUARD_SIZE;
+  uint8_t *p = nil_sm_ptr ? nil_sm_ptr : bottom + tr->stkunused;
+  uint8_t n = NIL_CFG_STACK_MONITOR_CHUNK;
+
+  while (n-- && p > bottom) {
+    if (*--p != 0X55)
+      tr->stkunused = p - bottom;
+  }
+  if (p > bottom) {
+    nil_sm_ptr = p;
+    return;
+  }
+  /* Next thread.*/
+  nil_sm_ptr = NULL;
+#if WHG_MOD
+  if (++tr == nil.idlep)
+#else  /* WHG_MOD */
+  if (++tr == &nil.threads[NIL_CFG_NUM_THREADS])
+#endif  /* WHG_MOD */
+    tr = nil.threads;
+  nil_sm_thread = tr;
 }
+#endif /* NIL_CFG_STACK_MONITOR */
 
 /** @} */
@@ -30,7 +30,13 @@
 #ifndef _NIL_H_
 #define _NIL_H_
 
+/* A build for another target, like the host port in extras/host, may
+   select its own configuration and port headers.*/
+#if defined(NIL_CONF_HEADER)
+#include NIL_CONF_HEADER
+#else
 #include "nilconf.h"
+#endif
 #include "niltypes.h"
 
 /*===========================================================================*/
@@ -106,10 +112,36 @@
 #define NIL_THD_SLEEPING        1   /**< @brief Thread sleeping.            */
 #define NIL_THD_SUSP            2   /**< @brief Thread suspended.           */
 #define NIL_THD_WTSEM           3   /**< @brief Thread waiting on semaphore.*/
+#define NIL_THD_WTANY           4   /**< @brief Thread waiting for any
+                                         event flag.                        */
+#define NIL_THD_WTALL           5   /**< @brief Thread waiting for all
+                                         event flags.                       */
+#define NIL_THD_WTMTX           6   /**< @brief Thread waiting on mutex.    */
 #define NIL_THD_IS_READY(tr)    ((tr)->state == NIL_THD_READY)
 #define NIL_THD_IS_SLEEPING(tr) ((tr)->state == NIL_THD_SLEEPING)
 #define NIL_THD_IS_SUSP(tr)     ((tr)->state == NIL_THD_SUSP)
 #define NIL_THD_IS_WTSEM(tr)    ((tr)->state == NIL_THD_WTSEM)
+#define NIL_THD_IS_WTANY(tr)    ((tr)->state == NIL_THD_WTANY)
+#define NIL_THD_IS_WTALL(tr)    ((tr)->state == NIL_THD_WTALL)
+#define NIL_THD_IS_WTMTX(tr)    ((tr)->state == NIL_THD_WTMTX)
+/** @} */
+
+/**
+ * @name    Trace event types
+ * @{
+ */
+#define NIL_TRACE_SWITCH        1   /**< @brief Context switch, the argument
+                                         is the old thread index in the
+                                         high byte and its state in the
+                                         low byte.                          */
+#define NIL_TRACE_READY         2   /**< @brief Thread made ready, the
+                                         argument is the wakeup message.    */
+#define NIL_TRACE_SEM_WAIT      3   /**< @brief Thread waits on a semaphore,
+                                         the argument is its address.       */
+#define NIL_TRACE_SEM_SIGNAL    4   /**< @brief Semaphore signaled, the
+                                         argument is its address.           */
+#define NIL_TRACE_IRQ_ENTER     5   /**< @brief IRQ handler entered.        */
+#define NIL_TRACE_IRQ_EXIT      6   /**< @brief IRQ handler exited.         */
 /** @} */
 
 /*===========================================================================*/
@@ -146,6 +178,131 @@
 #define NIL_CFG_TIMEDELTA                   0
 #endif
 
+/**
+ * @brief   Ready threads bit mask.
+ * @details If enabled the scheduler keeps a bit mask of the ready threads
+ *          and selects the next thread in constant time instead of
+ *          scanning the threads array.  Semaphores also keep a mask of
+ *          their waiting threads so a signal does not scan the array.
+ * @note    Thread masks limit the application to 15 user threads.
+ */
+#if !defined(NIL_CFG_USE_READY_MASK) || defined(__DOXYGEN__)
+#define NIL_CFG_USE_READY_MASK              TRUE
+#endif
+
+/**
+ * @brief   Event flags.
+ * @details If enabled, threads can wait for any or all of a set of flags
+ *          in an event flags object.
+ */
+#if !defined(NIL_CFG_USE_EVENTS) || defined(__DOXYGEN__)
+#define NIL_CFG_USE_EVENTS                  FALSE
+#endif
+
+/**
+ * @brief   Mutexes.
+ * @details If enabled, mutexes with priority inheritance are available.
+ * @note    The scheduler does a little more work when a thread is made
+ *          ready if this option is enabled.
+ */
+#if !defined(NIL_CFG_USE_MUTEXES) || defined(__DOXYGEN__)
+#define NIL_CFG_USE_MUTEXES                 FALSE
+#endif
+
+/**
+ * @brief   Virtual timers.
+ * @details If enabled, callbacks can be run by the system timer handler
+ *          after a delay, once or periodically, without a thread.
+ */
+#if !defined(NIL_CFG_USE_VIRTUAL_TIMERS) || defined(__DOXYGEN__)
+#define NIL_CFG_USE_VIRTUAL_TIMERS          FALSE
+#endif
+
+/**
+ * @brief   Kernel event trace.
+ * @details If enabled, context switches, thread wakeups, semaphore
+ *          operations, and IRQ entry and exit are recorded in a ring
+ *          buffer of time stamped events.
+ */
+#if !defined(NIL_CFG_TRACE) || defined(__DOXYGEN__)
+#define NIL_CFG_TRACE                       FALSE
+#endif
+
+/**
+ * @brief   Number of events in the trace buffer.
+ * @note    Each event requires six bytes of RAM.
+ */
+#if !defined(NIL_CFG_TRACE_SIZE) || defined(__DOXYGEN__)
+#define NIL_CFG_TRACE_SIZE                  64
+#endif
+
+/**
+ * @brief   Per-thread CPU usage.
+ * @details If enabled, the time stamp counter is sampled at each context
+ *          switch and the elapsed time is added to the run time of the
+ *          thread switched out.
+ */
+#if !defined(NIL_CFG_CPU_USAGE) || defined(__DOXYGEN__)
+#define NIL_CFG_CPU_USAGE                   FALSE
+#endif
+
+/**
+ * @brief   Kernel lock profile.
+ * @details If enabled, @p nilSysLock() and @p nilSysUnlock() time stamp
+ *          each lock section.  The longest section, its lock address and
+ *          a histogram of section lengths are recorded.
+ */
+#if !defined(NIL_CFG_LOCK_PROFILE) || defined(__DOXYGEN__)
+#define NIL_CFG_LOCK_PROFILE                FALSE
+#endif
+
+/**
+ * @brief   Number of lock profile histogram bins.
+ * @details Bin zero counts sections shorter than one time stamp count,
+ *          bin @p n counts sections of 2^(n-1) to 2^n - 1 counts, and the
+ *          last bin also counts all longer sections.
+ * @note    Each bin requires four bytes of RAM.
+ */
+#if !defined(NIL_CFG_LOCK_PROFILE_BINS) || defined(__DOXYGEN__)
+#define NIL_CFG_LOCK_PROFILE_BINS           8
+#endif
+
+/**
+ * @brief   NilStatsFIFO record latency.
+ * @details If enabled, @p NilStatsFIFO time stamps each record and keeps
+ *          a histogram of the time from @p signalData() to @p waitData().
+ */
+#if !defined(NIL_CFG_FIFO_LATENCY) || defined(__DOXYGEN__)
+#define NIL_CFG_FIFO_LATENCY                FALSE
+#endif
+
+/**
+ * @brief   Stack overflow check.
+ * @details If enabled, @p NIL_WORKING_AREA() reserves a guard word at the
+ *          bottom of each working area and the guard is compared when
+ *          the thread is switched out.
+ */
+#if !defined(NIL_CFG_STACK_CHECK) || defined(__DOXYGEN__)
+#define NIL_CFG_STACK_CHECK                 FALSE
+#endif
+
+/**
+ * @brief   Stack high-water mark monitor.
+ * @details If enabled, @p NIL_STACK_MONITOR_STEP() in the idle enter hook
+ *          updates the unused stack count of one thread a chunk at a time.
+ */
+#if !defined(NIL_CFG_STACK_MONITOR) || defined(__DOXYGEN__)
+#define NIL_CFG_STACK_MONITOR               FALSE
+#endif
+
+/**
+ * @brief   Stack bytes checked by each step of the stack monitor.
+ * @note    Each step runs with the kernel locked.
+ */
+#if !defined(NIL_CFG_STACK_MONITOR_CHUNK) || defined(__DOXYGEN__)
+#define NIL_CFG_STACK_MONITOR_CHUNK         8
+#endif
+
 /**
  * @brief   System assertions.
  */
@@ -180,11 +337,72 @@
 #error "invalid NIL_CFG_FREQUENCY specified"
 #endif
 
+/**
+ * @brief   Maximum number of threads, including the idle thread, that
+ *          can be represented in a @p thdmask_t.
+ */
+#define NIL_MASK_MAX_THREADS            (sizeof(thdmask_t) * 8)
+
+/**
+ * @brief   Threads have a bit in a @p thdmask_t.
+ * @details The ready mask, with semaphore waiter masks, event flags and
+ *          mutexes limit the threads table, idle thread included, to
+ *          @p NIL_MASK_MAX_THREADS entries.
+ */
+#define NIL_USE_THD_MASK                (NIL_CFG_USE_READY_MASK ||          \
+                                         NIL_CFG_USE_EVENTS ||              \
+                                         NIL_CFG_USE_MUTEXES)
+
+#if NIL_CFG_STACK_CHECK || defined(__DOXYGEN__)
+/**
+ * @brief   Stack guard value, differs from the 0X55 stack fill.
+ */
+#define NIL_STACK_GUARD                 0XA5C3
+
+/**
+ * @brief   Working area bytes reserved for the stack guard.
+ */
+#define NIL_STACK_GUARD_SIZE            sizeof(uint16_t)
+#else /* !NIL_CFG_STACK_CHECK */
+#define NIL_STACK_GUARD_SIZE            0
+#endif /* !NIL_CFG_STACK_CHECK */
+
 #if (NIL_CFG_TIMEDELTA < 0) || (NIL_CFG_TIMEDELTA == 1)
 #error "invalid NIL_CFG_TIMEDELTA specified"
 #endif
 
-#if NIL_CFG_ENABLE_ASSERTS  || defined(__DOXYGEN__)
+#if NIL_CFG_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Longest interval between tick-less alarms in timer counts.
+ * @details An alarm is set at least this often while timeouts are
+ *          pending so timeouts, kept relative to the last alarm, fit in
+ *          a @p systime_t.
+ */
+#define NIL_ALARM_MAX_DELTA             ((systime_t)0X2000)
+
+/**
+ * @brief   Longest timeout in tick-less mode in timer counts.
+ * @details The 16-bit counter range less the alarm interval and a margin
+ *          for a late alarm.  About 196 msec with F_CPU/64.
+ */
+#define NIL_MAX_TIMEOUT                                                     \
+  ((systime_t)(0XFFFF - 2 * NIL_ALARM_MAX_DELTA))
+#endif /* NIL_CFG_TIMEDELTA > 0 */
+
+#if NIL_CFG_USE_MUTEXES && !NIL_CFG_USE_READY_MASK
+#error "NIL_CFG_USE_MUTEXES requires NIL_CFG_USE_READY_MASK"
+#endif
+
+#if NIL_CFG_TRACE && ((NIL_CFG_TRACE_SIZE < 1) || (NIL_CFG_TRACE_SIZE > 255))
+#error "invalid NIL_CFG_TRACE_SIZE specified"
+#endif
+
+#if NIL_CFG_LOCK_PROFILE &&                                                 \
+    ((NIL_CFG_LOCK_PROFILE_BINS < 1) || (NIL_CFG_LOCK_PROFILE_BINS > 17))
+#error "invalid NIL_CFG_LOCK_PROFILE_BINS specified"
+#endif
+
+#if NIL_CFG_ENABLE_ASSERTS || NIL_CFG_STACK_CHECK || defined(__DOXYGEN__)
 /** enable debuging */
 #define NIL_DBG_ENABLED                 TRUE
 #else
@@ -205,8 +423,99 @@ typedef struct port_intctx intctx_t;
  */
 typedef struct {
   volatile cnt_t    cnt;        /**< @brief Semaphore counter.              */
+#if NIL_CFG_USE_READY_MASK || defined(__DOXYGEN__)
+  thdmask_t         waiters;    /**< @brief Mask of the waiting threads.    */
+#endif
 } semaphore_t;
 
+#if NIL_CFG_USE_EVENTS || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a structure representing an event flags object.
+ */
+typedef struct {
+  volatile eventmask_t flags;   /**< @brief Pending event flags.            */
+  thdmask_t         waiters;    /**< @brief Mask of the waiting threads.    */
+} event_flags_t;
+#endif
+
+#if NIL_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+/**
+ * @brief   Type of a structure representing a mutex.
+ */
+typedef struct {
+  struct nil_thread *owner;     /**< @brief Owner thread, NULL if free.     */
+  thdmask_t         waiters;    /**< @brief Mask of the waiting threads.    */
+} mutex_t;
+#endif
+
+/**
+ * @brief   Header of a free block in a memory pool.
+ */
+typedef struct nil_pool_header {
+  struct nil_pool_header *next; /**< @brief Next free block.                */
+} pool_header_t;
+
+/**
+ * @brief   Type of a structure representing a fixed-size block memory
+ *          pool.
+ */
+typedef struct {
+  pool_header_t     *next;      /**< @brief First free block.               */
+  semaphore_t       sem;        /**< @brief Free blocks semaphore.          */
+  cnt_t             minfree;    /**< @brief Minimum free block count.       */
+} memory_pool_t;
+
+/**
+ * @brief   Type of a structure representing a mailbox.
+ * @details A mailbox is a ring of @p msg_t slots.  A slot can also hold
+ *          a pointer if pointers fit in a @p msg_t, as on AVR.
+ */
+typedef struct {
+  msg_t             *buffer;    /**< @brief Pointer to the slots buffer.    */
+  msg_t             *top;       /**< @brief Pointer to the first location
+                                            after the buffer.               */
+  msg_t             *wrptr;     /**< @brief Write pointer.                  */
+  msg_t             *rdptr;     /**< @brief Read pointer.                   */
+  semaphore_t       fullsem;    /**< @brief Full slots semaphore.           */
+  semaphore_t       emptysem;   /**< @brief Empty slots semaphore.          */
+} mailbox_t;
+
+#if NIL_CFG_USE_VIRTUAL_TIMERS || defined(__DOXYGEN__)
+/**
+ * @brief   Virtual timer callback function.
+ */
+typedef void (*vtfunc_t)(void *);
+
+/**
+ * @brief   Type of a structure representing a virtual timer.
+ */
+typedef struct nil_virtual_timer virtual_timer_t;
+
+/**
+ * @brief   Structure representing a virtual timer.
+ * @note    A timer must be zero initialized, as static variables are, or
+ *          initialized with @p nilVTObjectInit().
+ */
+struct nil_virtual_timer {
+  virtual_timer_t       *next;  /**< @brief Next timer in the timers list.  */
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+  virtual_timer_t       *prev;  /**< @brief Previous timer in the timers
+                                            list.                           */
+  systime_t             timeout;/**< @brief Ticks after the previous
+                                            timer in the timers list.       */
+#else
+  virtual_timer_t       *fnext; /**< @brief Next expired timer, used by
+                                            @p nilSysTimerHandlerI().       */
+  systime_t             timeout;/**< @brief Timeout counter, zero
+                                            if not armed.                   */
+#endif
+  systime_t             period; /**< @brief Ticks between callbacks, zero
+                                            for a one-shot timer.           */
+  vtfunc_t              func;   /**< @brief Callback function.              */
+  void                  *par;   /**< @brief Callback parameter.             */
+};
+#endif /* NIL_CFG_USE_VIRTUAL_TIMERS */
+
 /**
  * @brief Thread function.
  */
@@ -251,13 +560,84 @@ struct nil_thread {
     void                *p;     /**< @brief Generic pointer.                */
     thread_ref_t        *trp;   /**< @brief Pointer to thread reference.    */
     semaphore_t         *semp;  /**< @brief Pointer to semaphore.           */
+#if NIL_CFG_USE_EVENTS || defined(__DOXYGEN__)
+    event_flags_t       *efp;   /**< @brief Pointer to event flags.         */
+#endif
+#if NIL_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+    mutex_t             *mtxp;  /**< @brief Pointer to mutex.               */
+#endif
   } u1;
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+  volatile systime_t    timeout;/**< @brief Ticks after the previous
+                                            thread in the timeout list.     */
+  thread_ref_t          tmnext; /**< @brief Next thread in the timeout
+                                            list.                           */
+  thread_ref_t          tmprev; /**< @brief Previous thread in the timeout
+                                            list.                           */
+#else
   volatile systime_t    timeout;/**< @brief Timeout counter, zero
                                             if disabled.                    */
+#endif
+#if NIL_CFG_USE_EVENTS || defined(__DOXYGEN__)
+  eventmask_t           ewmask; /**< @brief Event flags being waited for.   */
+#endif
+#if NIL_CFG_CPU_USAGE || defined(__DOXYGEN__)
+  uint32_t              cputime;/**< @brief Run time in time stamp
+                                            counts.                         */
+  uint16_t              cpusnap;/**< @brief Run time at the last
+                                            snapshot, scaled.               */
+#endif
+#if NIL_CFG_STACK_CHECK || defined(__DOXYGEN__)
+  uint16_t              *guardp;/**< @brief Stack guard word.               */
+#endif
+#if NIL_CFG_STACK_MONITOR || defined(__DOXYGEN__)
+  uint16_t              stkunused;/**< @brief Unused stack bytes found by
+                                            the stack monitor.              */
+#endif
   /* Optional extra fields.*/
   NIL_CFG_THREAD_EXT_FIELDS
 };
 
+#if NIL_CFG_TRACE || defined(__DOXYGEN__)
+/**
+ * @brief   Trace buffer event.
+ */
+typedef struct {
+  uint8_t           type;       /**< @brief Event type.                     */
+  uint8_t           thd;        /**< @brief Thread index.                   */
+  uint16_t          time;       /**< @brief Time stamp.                     */
+  uint16_t          arg;        /**< @brief Event argument.                 */
+} nil_trace_event_t;
+
+/**
+ * @brief   Trace ring buffer.
+ */
+typedef struct {
+  uint8_t           next;       /**< @brief Index of the next event.        */
+  bool              full;       /**< @brief Buffer has wrapped.             */
+  bool              suspended;  /**< @brief Recording is suspended.         */
+  /** @brief Event ring buffer. */
+  nil_trace_event_t buffer[NIL_CFG_TRACE_SIZE];
+} nil_trace_buffer_t;
+#endif /* NIL_CFG_TRACE */
+
+#if NIL_CFG_LOCK_PROFILE || defined(__DOXYGEN__)
+/**
+ * @brief   Kernel lock profile.
+ */
+typedef struct {
+  uint16_t          start;      /**< @brief Time stamp of the lock.         */
+  void              *site;      /**< @brief Lock address, NULL if no
+                                            section is being timed.         */
+  uint16_t          max;        /**< @brief Longest section in time stamp
+                                            counts.                         */
+  void              *maxsite;   /**< @brief Lock address of the longest
+                                            section.                        */
+  /** @brief Histogram of section lengths. */
+  uint32_t          hist[NIL_CFG_LOCK_PROFILE_BINS];
+} nil_lock_profile_t;
+#endif /* NIL_CFG_LOCK_PROFILE */
+
 /**
  * @brief   System data structure.
  * @note    This structure contain all the data areas used by the OS except
@@ -272,6 +652,9 @@ typedef struct {
    * @brief   Pointer to the next thread to be executed.
    * @note    This pointer must point at the same thread pointed by @p currp
    *          or to an higher priority thread if a switch is required.
+   * @note    If mutexes are enabled this is the priority the running thread
+   *          executes at.  It may point to a thread waiting on a mutex, the
+   *          mutex owner then runs in place of the waiting thread.
    */
   thread_ref_t      next;
 #if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
@@ -306,6 +689,47 @@ typedef struct {
    */
   thread_t          threads[NIL_CFG_NUM_THREADS + 1];
 #endif  /* WHG_MOD */
+#if NIL_CFG_USE_READY_MASK || defined(__DOXYGEN__)
+  /**
+   * @brief   Mask of the ready threads, bit zero is the highest priority
+   *          thread.
+   */
+  thdmask_t         readymask;
+#endif
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+  /**
+   * @brief   First thread in the timeout list.
+   * @details Threads waiting with a timeout are ordered by expiration time
+   *          so a tick only decrements the first thread's timeout.
+   */
+  thread_ref_t      tmlist;
+#endif
+#if NIL_CFG_USE_VIRTUAL_TIMERS || defined(__DOXYGEN__)
+  /**
+   * @brief   First armed virtual timer.
+   * @details In tick mode the list is ordered by expiration time like
+   *          @p tmlist, in tick-less mode it is not ordered.
+   */
+  virtual_timer_t   *vtlist;
+#endif
+#if NIL_CFG_TRACE || defined(__DOXYGEN__)
+  /**
+   * @brief   Trace buffer.
+   */
+  nil_trace_buffer_t trace;
+#endif
+#if NIL_CFG_CPU_USAGE || defined(__DOXYGEN__)
+  /**
+   * @brief   Time stamp of the last CPU usage update.
+   */
+  uint16_t          cpustamp;
+#endif
+#if NIL_CFG_LOCK_PROFILE || defined(__DOXYGEN__)
+  /**
+   * @brief   Kernel lock profile.
+   */
+  nil_lock_profile_t lockprof;
+#endif
 #if NIL_DBG_ENABLED || defined(__DOXYGEN__)
   /**
    * @brief   Panic message.
@@ -320,6 +744,29 @@ typedef struct {
 /* Module macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Compile time assertion at file or class scope.
+ * @details A false @p cond is a compile error.  Arduino compiles sketches
+ *          as gnu++11 so C++ uses @p static_assert.  C files, like the
+ *          host port tests, get a negative array size in a typedef named
+ *          after @p msg.
+ */
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define NIL_STATIC_ASSERT(cond, msg) static_assert(cond, #msg)
+#else  /* __cplusplus */
+#define NIL_STATIC_ASSERT(cond, msg)                                        \
+  typedef char nil_static_assert_##msg[(cond) ? 1 : -1]
+#endif  /* __cplusplus */
+
+/**
+ * @brief   Working area size checked at compile time.
+ * @details A working area smaller than @p THD_WA_SIZE(0) can't hold the
+ *          thread context and interrupt stack, it is a negative array
+ *          size compile error.
+ */
+#define NIL_WA_SIZE_CHECK(size)                                             \
+  ((size) + 0 * sizeof(char[(size) >= THD_WA_SIZE(0) ? 1 : -1]))
+
 /**
  * @name    Threads tables definition macros
  * @{
@@ -336,19 +783,48 @@ typedef struct {
 #endif  /* WHG_MOD */
 /**
  * @brief   Entry of user threads table
+ * @note    Working areas are the application's @p NIL_WORKING_AREA
+ *          arrays, the table does not lay them out.  On AVR
+ *          @p stkalign_t is one byte so there is no padding to save, and
+ *          table owned stacks would change every sketch.
  */
+#if WHG_MOD
+#define NIL_THREADS_TABLE_ENTRY(name, funcp, arg, wap, size)                \
+  {name, funcp, arg, wap, NIL_WA_SIZE_CHECK(size)},
+#else  /* WHG_MOD */
 #define NIL_THREADS_TABLE_ENTRY(name, funcp, arg, wap, size)                \
   {name, funcp, arg, wap, size},
+#endif  /* WHG_MOD */
+
+#if WHG_MOD || defined(__DOXYGEN__)
+/**
+ * @brief   Initializer for the time fields of @p nil_system_t.
+ */
+#if NIL_CFG_TIMEDELTA == 0
+#define NIL_TIME_INIT 0,
+#else  /* NIL_CFG_TIMEDELTA */
+#define NIL_TIME_INIT 0, 0,
+#endif  /* NIL_CFG_TIMEDELTA */
+#endif  /* WHG_MOD */
 
 /**
  * @brief   End of user threads table.
+ * @details The thread count is the size of the table.  A table with no
+ *          user threads is a compile error.  If @p NIL_USE_THD_MASK is
+ *          TRUE more threads than bits in a @p thdmask_t, the idle thread
+ *          included, is also a compile error.
  */
 #if WHG_MOD
 #define NIL_THREADS_TABLE_END()                                             \
   {"idle", 0, NULL, NULL, 0}                                                \
 };                                                                          \
+NIL_STATIC_ASSERT(sizeof(nil_thd_configs)/sizeof(thread_config_t) > 1,      \
+                  no_user_threads);                                         \
+NIL_STATIC_ASSERT(!NIL_USE_THD_MASK ||                                      \
+                  sizeof(nil_thd_configs)/sizeof(thread_config_t) <=        \
+                  NIL_MASK_MAX_THREADS, too_many_threads);                  \
 static thread_t nil_threads[sizeof(nil_thd_configs)/sizeof(thread_config_t)];  \
-nil_system_t nil = {0, 0, 0, nil_threads,                                      \
+nil_system_t nil = {0, 0, NIL_TIME_INIT nil_threads,                           \
 &nil_threads[sizeof(nil_thd_configs)/sizeof(thread_config_t) - 1]};            \
 const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) - 1;
 #else  /* WHG_MOD */
@@ -362,6 +838,15 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  * @name    Macro Functions
  * @{
  */
+/**
+ * @brief   Bit mask of a thread.
+ * @details The bit position is the thread index in the threads array so
+ *          lower bits have higher priority.
+ *
+ * @param[in] tr        reference to the @p thread_t object
+ */
+#define NIL_THD_MASK(tr) ((thdmask_t)1 << ((tr) - nil.threads))
+
 /**
  * @brief   System halt state.
  */
@@ -386,14 +871,22 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  *
  * @special
  */
+#if NIL_CFG_LOCK_PROFILE || defined(__DOXYGEN__)
+#define nilSysLock() do {port_lock(); NIL_LOCK_PROFILE_START();} while (0)
+#else
 #define nilSysLock() port_lock()
+#endif
 
 /**
  * @brief   Leaves the kernel lock mode.
  *
  * @special
  */
+#if NIL_CFG_LOCK_PROFILE || defined(__DOXYGEN__)
+#define nilSysUnlock() do {NIL_LOCK_PROFILE_STOP(); port_unlock();} while (0)
+#else
 #define nilSysUnlock() port_unlock()
+#endif
 
 /**
  * @brief   Enters the kernel lock mode from within an interrupt handler.
@@ -495,7 +988,11 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  *
  * @init
  */
-#define nilSemInit(sp, n) ((sp)->cnt = n)
+#if NIL_CFG_USE_READY_MASK || defined(__DOXYGEN__)
+#define nilSemInit(sp, n) ((sp)->cnt = (n), (sp)->waiters = 0)
+#else
+#define nilSemInit(sp, n) ((sp)->cnt = (n))
+#endif
 
 /**
  * @brief   Performs a wait operation on a semaphore.
@@ -525,6 +1022,134 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  */
 #define nilSemWaitS(sp) nilSemWaitTimeoutS(sp, TIME_INFINITE)
 
+#if NIL_CFG_USE_EVENTS || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes an event flags object with no pending flags.
+ *
+ * @param[out] efp      pointer to an @p event_flags_t structure
+ *
+ * @init
+ */
+#define nilEvtInit(efp) ((efp)->flags = 0, (efp)->waiters = 0)
+
+/**
+ * @brief   Waits for any of the specified event flags.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to wait for, must not be zero
+ * @return              The event flags that released the thread, these
+ *                      flags are cleared in the object.
+ *
+ * @api
+ */
+#define nilEvtWaitAny(efp, mask) nilEvtWaitAnyTimeout(efp, mask, TIME_INFINITE)
+
+/**
+ * @brief   Waits for all of the specified event flags.
+ *
+ * @param[in] efp       pointer to an @p event_flags_t structure
+ * @param[in] mask      the event flags to wait for, must not be zero
+ * @return              The event flags in @p mask, these flags are
+ *                      cleared in the object.
+ *
+ * @api
+ */
+#define nilEvtWaitAll(efp, mask) nilEvtWaitAllTimeout(efp, mask, TIME_INFINITE)
+#endif /* NIL_CFG_USE_EVENTS */
+
+#if NIL_CFG_USE_MUTEXES || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a mutex in the unlocked state.
+ *
+ * @param[out] mp       pointer to a @p mutex_t structure
+ *
+ * @init
+ */
+#define nilMtxInit(mp) ((mp)->owner = NULL, (mp)->waiters = 0)
+
+/**
+ * @brief   Locks a mutex.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ *
+ * @api
+ */
+#define nilMtxLock(mp) nilMtxLockTimeout(mp, TIME_INFINITE)
+
+/**
+ * @brief   Locks a mutex.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ *
+ * @sclass
+ */
+#define nilMtxLockS(mp) nilMtxLockTimeoutS(mp, TIME_INFINITE)
+
+/**
+ * @brief   Tries to lock a mutex without waiting.
+ *
+ * @param[in] mp        pointer to a @p mutex_t structure
+ * @retval true         if the mutex has been locked.
+ * @retval false        if the mutex is owned by another thread.
+ *
+ * @api
+ */
+#define nilMtxTryLock(mp)                                                   \
+  (nilMtxLockTimeout(mp, TIME_IMMEDIATE) == NIL_MSG_OK)
+#endif /* NIL_CFG_USE_MUTEXES */
+
+/**
+ * @brief   Allocates a block from a memory pool.
+ *
+ * @param[in] mp        pointer to a @p memory_pool_t structure
+ * @return              The pointer to the allocated block.
+ *
+ * @api
+ */
+#define nilPoolAlloc(mp) nilPoolAllocTimeout(mp, TIME_INFINITE)
+
+/**
+ * @brief   Posts a message into a mailbox.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ *
+ * @api
+ */
+#define nilMBPost(mbp, msg) nilMBPostTimeout(mbp, msg, TIME_INFINITE)
+
+/**
+ * @brief   Posts a high priority message into a mailbox.
+ * @details The message is inserted ahead of the pending messages so it
+ *          is the next message fetched.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[in] msg       the message to be posted
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly posted.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ *
+ * @api
+ */
+#define nilMBPostAhead(mbp, msg) nilMBPostAheadTimeout(mbp, msg, TIME_INFINITE)
+
+/**
+ * @brief   Retrieves a message from a mailbox.
+ *
+ * @param[in] mbp       pointer to a @p mailbox_t structure
+ * @param[out] msgp     pointer to a message variable for the received
+ *                      message
+ * @return              The operation status.
+ * @retval NIL_MSG_OK   if a message has been correctly fetched.
+ * @retval NIL_MSG_RST  if the mailbox has been reset while waiting.
+ *
+ * @api
+ */
+#define nilMBFetch(mbp, msgp) nilMBFetchTimeout(mbp, msgp, TIME_INFINITE)
+
 /**
  * @brief   Current system time.
  * @details Returns the number of system ticks since the @p nilSysInit()
@@ -559,6 +1184,36 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
 #define nilTimeIsWithin(time, start, end)                                   \
   ((end) > (start) ? ((time) >= (start)) && ((time) < (end)) :              \
                      ((time) >= (start)) || ((time) < (end)))
+
+#if NIL_CFG_USE_VIRTUAL_TIMERS || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a virtual timer object.
+ *
+ * @param[out] vtp      pointer to a @p virtual_timer_t structure
+ *
+ * @init
+ */
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+#define nilVTObjectInit(vtp) {(vtp)->prev = NULL; (vtp)->next = NULL;}
+#else
+#define nilVTObjectInit(vtp) {(vtp)->timeout = 0;}
+#endif
+
+/**
+ * @brief   Returns true if a virtual timer is armed.
+ * @note    A one-shot timer is not armed when its callback runs, a
+ *          periodic timer stays armed until reset.
+ *
+ * @param[in] vtp       pointer to a @p virtual_timer_t structure
+ *
+ * @iclass
+ */
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+#define nilVTIsArmedI(vtp) (((vtp)->prev != NULL) || (nil.vtlist == (vtp)))
+#else
+#define nilVTIsArmedI(vtp) ((vtp)->timeout != 0)
+#endif
+#endif /* NIL_CFG_USE_VIRTUAL_TIMERS */
 /** @} */
 
 /**
@@ -602,6 +1257,109 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
 #endif /* !NIL_CFG_ENABLE_ASSERTS */
 /** @} */
 
+/**
+ * @name    Trace macros
+ */
+#if NIL_CFG_TRACE || defined(__DOXYGEN__)
+/**
+ * @brief   Records an event in the trace buffer.
+ * @note    The macro does nothing if @p NIL_CFG_TRACE is FALSE.
+ *
+ * @param[in] type      the event type
+ * @param[in] tr        reference to the @p thread_t object
+ * @param[in] arg       the event argument
+ *
+ * @iclass
+ */
+#define NIL_TRACE_EVENT(type, tr, arg) nilTraceEventI(type, tr, arg)
+#else /* !NIL_CFG_TRACE */
+#define NIL_TRACE_EVENT(type, tr, arg)
+#endif /* !NIL_CFG_TRACE */
+/** @} */
+
+/**
+ * @name    CPU usage macros
+ */
+#if NIL_CFG_CPU_USAGE || defined(__DOXYGEN__)
+/**
+ * @brief   Adds the time since the last update to a thread's run time.
+ * @note    The macro does nothing if @p NIL_CFG_CPU_USAGE is FALSE.
+ *
+ * @param[in] tr        reference to the running @p thread_t object
+ *
+ * @iclass
+ */
+#define NIL_CPU_USAGE_UPDATE(tr) nilCpuUsageUpdateI(tr)
+#else /* !NIL_CFG_CPU_USAGE */
+#define NIL_CPU_USAGE_UPDATE(tr)
+#endif /* !NIL_CFG_CPU_USAGE */
+/** @} */
+
+/**
+ * @name    Lock profile macros
+ */
+#if NIL_CFG_LOCK_PROFILE || defined(__DOXYGEN__)
+/**
+ * @brief   Starts timing a lock section.
+ * @details Called with interrupts disabled by @p nilSysLock() and by
+ *          @p NIL_IRQ_PROLOGUE().  A thread switched in by an ISR can
+ *          end the section with @p nilSysUnlock() so the ISR is the
+ *          lock address of that section.
+ * @note    The macro does nothing if @p NIL_CFG_LOCK_PROFILE is FALSE.
+ *
+ * @special
+ */
+#define NIL_LOCK_PROFILE_START() nilLockProfileStartI()
+
+/**
+ * @brief   Stops timing a lock section.
+ * @note    The macro does nothing if @p NIL_CFG_LOCK_PROFILE is FALSE.
+ *
+ * @special
+ */
+#define NIL_LOCK_PROFILE_STOP() nilLockProfileStopI()
+#else /* !NIL_CFG_LOCK_PROFILE */
+#define NIL_LOCK_PROFILE_START()
+#define NIL_LOCK_PROFILE_STOP()
+#endif /* !NIL_CFG_LOCK_PROFILE */
+/** @} */
+
+/**
+ * @name    Stack check macros
+ */
+#if NIL_CFG_STACK_CHECK || defined(__DOXYGEN__)
+/**
+ * @brief   Halts the system if a thread has overwritten its stack guard.
+ * @details The debug message is the thread name.
+ * @note    The macro does nothing if @p NIL_CFG_STACK_CHECK is FALSE.
+ *
+ * @param[in] tr        reference to the thread being switched out
+ *
+ * @sclass
+ */
+#define NIL_STACK_CHECK(tr) {                                               \
+  if (*(tr)->guardp != NIL_STACK_GUARD) {                                   \
+    nil.dbg_msg = nil_thd_configs[(tr) - nil.threads].namep;                \
+    nilSysHalt();                                                           \
+  }                                                                         \
+}
+#else /* !NIL_CFG_STACK_CHECK */
+#define NIL_STACK_CHECK(tr)
+#endif /* !NIL_CFG_STACK_CHECK */
+
+#if NIL_CFG_STACK_MONITOR || defined(__DOXYGEN__)
+/**
+ * @brief   Runs one step of the stack high-water mark monitor.
+ * @note    The macro does nothing if @p NIL_CFG_STACK_MONITOR is FALSE.
+ *
+ * @sclass
+ */
+#define NIL_STACK_MONITOR_STEP() nilStackMonitorStepS()
+#else /* !NIL_CFG_STACK_MONITOR */
+#define NIL_STACK_MONITOR_STEP()
+#endif /* !NIL_CFG_STACK_MONITOR */
+/** @} */
+
 /**
  * @name    ISRs abstraction macros
  */
@@ -612,7 +1370,11 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  *
  * @special
  */
-#define NIL_IRQ_PROLOGUE() PORT_IRQ_PROLOGUE()
+#define NIL_IRQ_PROLOGUE() {                                                \
+  PORT_IRQ_PROLOGUE();                                                      \
+  NIL_LOCK_PROFILE_START();                                                 \
+  NIL_TRACE_EVENT(NIL_TRACE_IRQ_ENTER, nil.current, 0);                     \
+}
 
 /**
  * @brief   IRQ handler exit code.
@@ -620,7 +1382,10 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  *
  * @special
  */
-#define NIL_IRQ_EPILOGUE() PORT_IRQ_EPILOGUE()
+#define NIL_IRQ_EPILOGUE() {                                                \
+  NIL_TRACE_EVENT(NIL_TRACE_IRQ_EXIT, nil.current, 0);                      \
+  PORT_IRQ_EPILOGUE();                                                      \
+}
 
 /**
  * @brief   Standard normal IRQ handler declaration.
@@ -650,6 +1415,21 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  * @name    Time conversion utilities
  * @{
  */
+/**
+ * @brief   Checks a converted time.
+ * @details In tick-less mode with assertions enabled a time longer than
+ *          @p NIL_MAX_TIMEOUT halts the system instead of being truncated
+ *          to a short timeout.
+ *
+ * @param[in] st        the number of ticks as a 32-bit value
+ * @return              The number of ticks.
+ */
+#if (NIL_CFG_TIMEDELTA > 0 && NIL_CFG_ENABLE_ASSERTS) || defined(__DOXYGEN__)
+#define NIL_ST_CHECK(st) nil_st_check(st)
+#else
+#define NIL_ST_CHECK(st) ((systime_t)(st))
+#endif
+
 /**
  * @brief   Seconds to system ticks.
  * @details Converts from seconds to system ticks number.
@@ -661,7 +1441,7 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  * @api
  */
 #define S2ST(sec)                                                           \
-  ((systime_t)((sec) * NIL_CFG_FREQUENCY))
+  NIL_ST_CHECK((uint32_t)(sec) * (uint32_t)NIL_CFG_FREQUENCY)
 
 /**
  * @brief   Milliseconds to system ticks.
@@ -674,7 +1454,7 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  * @api
  */
 #define MS2ST(msec)                                                         \
-  ((systime_t)(((((uint32_t)(msec)) * ((uint32_t)NIL_CFG_FREQUENCY) - 1UL) /\
+  NIL_ST_CHECK((((((uint32_t)(msec)) * ((uint32_t)NIL_CFG_FREQUENCY) - 1UL) /\
                 1000UL) + 1UL))
 
 /**
@@ -688,7 +1468,7 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
  * @api
  */
 #define US2ST(usec)                                                         \
-  ((systime_t)(((((uint32_t)(usec)) * ((uint32_t)NIL_CFG_FREQUENCY) - 1UL) /\
+  NIL_ST_CHECK((((((uint32_t)(usec)) * ((uint32_t)NIL_CFG_FREQUENCY) - 1UL) /\
                 1000000UL) + 1UL))
 /** @} */
 
@@ -696,7 +1476,11 @@ const uint8_t nil_thd_count = sizeof(nil_thd_configs)/sizeof(thread_config_t) -
 /* External declarations.                                                    */
 /*===========================================================================*/
 
+#if defined(NIL_PORT_HEADER)
+#include NIL_PORT_HEADER
+#else
 #include "nilcore.h"
+#endif
 
 #if !defined(__DOXYGEN__)
 extern nil_system_t nil;
@@ -708,6 +1492,14 @@ extern const thread_config_t nil_thd_configs[NIL_CFG_NUM_THREADS + 1];
 #endif  /* WHG_MOD */
 #endif
 
+#if NIL_CFG_TIMEDELTA > 0 && NIL_CFG_ENABLE_ASSERTS
+static inline systime_t nil_st_check(uint32_t st) {
+
+  nilDbgAssert(st <= NIL_MAX_TIMEOUT, "NIL_ST_CHECK(), #1", "too long");
+  return (systime_t)st;
+}
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -730,6 +1522,64 @@ extern "C" {
   void nilSemSignalI(semaphore_t *sp);
   void nilSemReset(semaphore_t *sp, cnt_t n);
   void nilSemResetI(semaphore_t *sp, cnt_t n);
+#if NIL_CFG_USE_EVENTS
+  eventmask_t nilEvtWaitAnyTimeout(event_flags_t *efp, eventmask_t mask,
+                                   systime_t timeout);
+  eventmask_t nilEvtWaitAnyTimeoutS(event_flags_t *efp, eventmask_t mask,
+                                    systime_t timeout);
+  eventmask_t nilEvtWaitAllTimeout(event_flags_t *efp, eventmask_t mask,
+                                   systime_t timeout);
+  eventmask_t nilEvtWaitAllTimeoutS(event_flags_t *efp, eventmask_t mask,
+                                    systime_t timeout);
+  void nilEvtSignal(event_flags_t *efp, eventmask_t mask);
+  void nilEvtSignalI(event_flags_t *efp, eventmask_t mask);
+#endif
+#if NIL_CFG_USE_MUTEXES
+  msg_t nilMtxLockTimeout(mutex_t *mp, systime_t timeout);
+  msg_t nilMtxLockTimeoutS(mutex_t *mp, systime_t timeout);
+  void nilMtxUnlock(mutex_t *mp);
+  void nilMtxUnlockS(mutex_t *mp);
+#endif
+  void nilPoolInit(memory_pool_t *mp, void *p, size_t size, cnt_t n);
+  void *nilPoolAllocTimeout(memory_pool_t *mp, systime_t timeout);
+  void *nilPoolAllocTimeoutS(memory_pool_t *mp, systime_t timeout);
+  void *nilPoolAllocI(memory_pool_t *mp);
+  void nilPoolFree(memory_pool_t *mp, void *objp);
+  void nilPoolFreeI(memory_pool_t *mp, void *objp);
+  void nilMBInit(mailbox_t *mbp, msg_t *buf, cnt_t n);
+  void nilMBReset(mailbox_t *mbp);
+  void nilMBResetI(mailbox_t *mbp);
+  msg_t nilMBPostTimeout(mailbox_t *mbp, msg_t msg, systime_t timeout);
+  msg_t nilMBPostTimeoutS(mailbox_t *mbp, msg_t msg, systime_t timeout);
+  msg_t nilMBPostI(mailbox_t *mbp, msg_t msg);
+  msg_t nilMBPostAheadTimeout(mailbox_t *mbp, msg_t msg, systime_t timeout);
+  msg_t nilMBPostAheadTimeoutS(mailbox_t *mbp, msg_t msg, systime_t timeout);
+  msg_t nilMBPostAheadI(mailbox_t *mbp, msg_t msg);
+  msg_t nilMBFetchTimeout(mailbox_t *mbp, msg_t *msgp, systime_t timeout);
+  msg_t nilMBFetchTimeoutS(mailbox_t *mbp, msg_t *msgp, systime_t timeout);
+  msg_t nilMBFetchI(mailbox_t *mbp, msg_t *msgp);
+#if NIL_CFG_USE_VIRTUAL_TIMERS
+  void nilVTSet(virtual_timer_t *vtp, systime_t delay, systime_t period,
+                vtfunc_t func, void *par);
+  void nilVTSetI(virtual_timer_t *vtp, systime_t delay, systime_t period,
+                 vtfunc_t func, void *par);
+  void nilVTReset(virtual_timer_t *vtp);
+  void nilVTResetI(virtual_timer_t *vtp);
+#endif
+#if NIL_CFG_TRACE
+  void nilTraceEventI(uint8_t type, thread_ref_t tr, uint16_t arg);
+#endif
+#if NIL_CFG_CPU_USAGE
+  void nilCpuUsageUpdateI(thread_ref_t tr);
+  void nilCpuUsageSnapshotS(void);
+#endif
+#if NIL_CFG_LOCK_PROFILE
+  void nilLockProfileStartI(void);
+  void nilLockProfileStopI(void);
+#endif
+#if NIL_CFG_STACK_MONITOR
+  void nilStackMonitorStepS(void);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -28,6 +28,98 @@
 #include <NilRTOS.h>
 #include <avr_heap.h>
 //------------------------------------------------------------------------------
+#if NIL_CFG_CPU_USAGE
+/** Print percent CPU usage for all threads and restart the measurement.
+ *
+ * Each value is the percent of time since the previous call, or since
+ * the start of the kernel, that a thread was running.  The last value
+ * is the idle thread so it is the unused CPU time.  Time in ISRs is
+ * charged to the interrupted thread.
+ *
+ * Call at least every few hours since run times overflow after
+ * 2^32 time stamp counts.
+ *
+ * @param[in] pr Print stream for output.
+ */
+void nilPrintCpuUsage(Print* pr) {
+  uint32_t total = 0;
+  uint8_t i;
+
+  // Take a consistent snapshot and restart the measurement.
+  nilSysLock();
+  nilCpuUsageSnapshotS();
+  nilSysUnlock();
+
+  for (i = 0; i <= nil_thd_count; i++) total += nil.threads[i].cpusnap;
+  pr->print(F("CPU Usage %: "));
+  for (i = 0; i <= nil_thd_count; i++) {
+    uint16_t p = total ?
+      (nil.threads[i].cpusnap*1000UL + total/2)/total : 0;
+    pr->print(p/10);
+    pr->print('.');
+    pr->print(p%10);
+    if (i < nil_thd_count) pr->print(' ');
+  }
+  pr->println();
+}
+#endif  // NIL_CFG_CPU_USAGE
+//------------------------------------------------------------------------------
+#if NIL_CFG_LOCK_PROFILE
+/** Print the kernel lock profile and restart the measurement.
+ *
+ * The longest time interrupts were disabled by a kernel lock is printed
+ * with its lock address.  Then one line per histogram bin has the
+ * shortest lock time of the bin in usec and the count of locks.  On AVR
+ * the address is a word address, double it to find the code in the
+ * avr-objdump listing.
+ *
+ * @param[in] pr Print stream for output.
+ */
+void nilPrintLockProfile(Print* pr) {
+  nil_lock_profile_t lp;
+  uint8_t i;
+
+  // Take a consistent snapshot and restart the measurement.
+  nilSysLock();
+  lp = nil.lockprof;
+  nil.lockprof.max = 0;
+  nil.lockprof.maxsite = NULL;
+  for (i = 0; i < NIL_CFG_LOCK_PROFILE_BINS; i++) {
+    nil.lockprof.hist[i] = 0;
+  }
+  nilSysUnlock();
+
+  pr->print(F("Max lock usec: "));
+  pr->println(HR2US(lp.max));
+  pr->print(F("Max lock address: 0X"));
+  pr->println((uintptr_t)lp.maxsite, HEX);
+  pr->println(F("Lock usec,count"));
+  for (i = 0; i < NIL_CFG_LOCK_PROFILE_BINS; i++) {
+    pr->print(i ? HR2US(1UL << (i - 1)) : 0);
+    pr->print(',');
+    pr->println(lp.hist[i]);
+  }
+}
+#endif  // NIL_CFG_LOCK_PROFILE
+//------------------------------------------------------------------------------
+#if NIL_CFG_STACK_MONITOR
+/** Print unused byte count for all thread stacks found by the stack monitor.
+ *
+ * Unlike nilPrintUnusedStack() no stack is scanned so this is fast enough
+ * to call while threads are busy.
+ *
+ * @param[in] pr Print stream for output.
+ */
+void nilPrintStackMonitor(Print* pr) {
+  pr->print(F("Stack Monitor: "));
+  for (uint8_t i = 0; i < nil_thd_count; i++) {
+    if (i) pr->print(' ');
+    pr->print(nilStackMonitorUnused(i));
+  }
+  pr->println();
+}
+#endif  // NIL_CFG_STACK_MONITOR
+//------------------------------------------------------------------------------
 /** Print size of all all stacks.
  * @param[in] pr Print stream for output.
  */
@@ -42,6 +134,60 @@ void nilPrintStackSizes(Print* pr) {
   pr->println(nilHeapIdleSize());
 }
 //------------------------------------------------------------------------------
+#if NIL_CFG_TRACE
+/** Print the trace buffer, oldest event first, and restart the trace.
+ *
+ * The output is CSV for NilTraceDecode.py in the extras folder.
+ * The first line is the CPU frequency and CPU cycles per time stamp
+ * count.  Thread lines are followed by one line per event.
+ *
+ * @param[in] pr Print stream for output.
+ */
+void nilPrintTrace(Print* pr) {
+  const thread_config_t *tcp = nil_thd_configs;
+  uint8_t i, n;
+
+  // Stop recording while the buffer is printed.
+  nilSysLock();
+  nil.trace.suspended = true;
+  nilSysUnlock();
+
+  pr->print(F("NilTrace,"));
+  pr->print(F_CPU);
+  pr->print(',');
+  pr->println(PORT_TIME_STAMP_CYCLES);
+  for (i = 0; i <= nil_thd_count; i++, tcp++) {
+    pr->print(F("T,"));
+    pr->print(i);
+    pr->print(',');
+    if (tcp->namep) {
+      pr->println(tcp->namep);
+    } else {
+      pr->println(F("thread"));
+    }
+  }
+  i = nil.trace.full ? nil.trace.next : 0;
+  n = nil.trace.full ? NIL_CFG_TRACE_SIZE : nil.trace.next;
+  while (n--) {
+    nil_trace_event_t* ep = &nil.trace.buffer[i];
+    pr->print(F("E,"));
+    pr->print(ep->time);
+    pr->print(',');
+    pr->print(ep->type);
+    pr->print(',');
+    pr->print(ep->thd);
+    pr->print(',');
+    pr->println(ep->arg);
+    if (++i >= NIL_CFG_TRACE_SIZE) i = 0;
+  }
+  nilSysLock();
+  nil.trace.next = 0;
+  nil.trace.full = false;
+  nil.trace.suspended = false;
+  nilSysUnlock();
+}
+#endif  // NIL_CFG_TRACE
+//------------------------------------------------------------------------------
 /** Print unused byte count for all stacks.
  * @param[in] pr Print stream for output.
  */
@@ -49,7 +195,9 @@ void nilPrintUnusedStack(Print* pr) {
   const thread_config_t *tcp = nil_thd_configs;
   pr->print(F("Unused Stack: "));
   while (tcp->wap) {
-    pr->print(fillSize((uint8_t*)tcp->wap, (uint8_t*)tcp->wap + tcp->size));
+    // Skip the stack guard.
+    pr->print(fillSize((uint8_t*)tcp->wap + NIL_STACK_GUARD_SIZE,
+                       (uint8_t*)tcp->wap + tcp->size));
     pr->print(' ');
     tcp++;
   }
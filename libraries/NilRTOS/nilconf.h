@@ -44,11 +44,19 @@
  * @brief   Number of user threads in the application.
  * @note    This number is not inclusive of the idle thread which is
  *          Implicitly handled.
+ * @note    Not used with WHG_MOD, the count is the size of the threads
+ *          table.  If the ready mask, event flags or mutexes are enabled
+ *          at most 15 user threads are allowed since each thread has a
+ *          bit in a @p thdmask_t, more is a compile error.
  */
 #define NIL_CFG_NUM_THREADS                 2
 
 /**
  * @brief   System tick frequency.
+ * @note    In tick-less mode this is the timer 1 count frequency and must
+ *          be F_CPU divided by 1, 8, 64, 256, or 1024.  F_CPU/64 gives
+ *          4 usec resolution and a maximum timeout of about 196 msec
+ *          on a 16 MHz Arduino, see @p NIL_MAX_TIMEOUT.
  */
 #define NIL_CFG_FREQUENCY                   (F_CPU/16384L)
 
@@ -59,9 +67,110 @@
  *          of ticks that is safe to specify in a timeout directive.
  *          The value one is not valid, timeouts are rounder up to
  *          this value.
+ * @note    Tick-less mode uses timer 1 so NilTimer1 can't be used.
+ *          The value should allow about 100 CPU cycles to program
+ *          the alarm, for example 4 with F_CPU/64.
  */
 #define NIL_CFG_TIMEDELTA                   0
 
+/**
+ * @brief   Ready threads bit mask.
+ * @details If TRUE the next thread is selected from a bit mask of ready
+ *          threads in constant time and semaphores keep a bit mask of
+ *          their waiting threads.  If FALSE the threads array is
+ *          scanned linearly.
+ * @note    If TRUE at most 15 user threads are allowed.
+ */
+#define NIL_CFG_USE_READY_MASK              TRUE
+
+/**
+ * @brief   Event flags.
+ * @details If TRUE, event flags objects are available.  Each thread uses
+ *          one more byte of RAM.
+ */
+#define NIL_CFG_USE_EVENTS                  FALSE
+
+/**
+ * @brief   Mutexes.
+ * @details If TRUE, mutexes with priority inheritance are available.
+ *          Requires @p NIL_CFG_USE_READY_MASK.
+ */
+#define NIL_CFG_USE_MUTEXES                 FALSE
+
+/**
+ * @brief   Virtual timers.
+ * @details If TRUE, callbacks can be run by the system timer handler
+ *          after a delay, once or periodically.  Each timer uses
+ *          twelve bytes of RAM.
+ */
+#define NIL_CFG_USE_VIRTUAL_TIMERS          FALSE
+
+/**
+ * @brief   Kernel event trace.
+ * @details If TRUE, kernel events are recorded in a ring buffer that
+ *          can be printed with @p nilPrintTrace().
+ */
+#define NIL_CFG_TRACE                       FALSE
+
+/**
+ * @brief   Number of events in the trace buffer, six bytes per event.
+ */
+#define NIL_CFG_TRACE_SIZE                  64
+
+/**
+ * @brief   Per-thread CPU usage.
+ * @details If TRUE, the run time of each thread is accumulated and can
+ *          be printed with @p nilPrintCpuUsage().  Each thread uses six
+ *          more bytes of RAM.
+ */
+#define NIL_CFG_CPU_USAGE                   FALSE
+
+/**
+ * @brief   Kernel lock profile.
+ * @details If TRUE, the time interrupts are disabled by each kernel lock
+ *          is measured.  Print the longest lock and a histogram with
+ *          @p nilPrintLockProfile().
+ */
+#define NIL_CFG_LOCK_PROFILE                FALSE
+
+/**
+ * @brief   Number of lock profile histogram bins, four bytes per bin.
+ */
+#define NIL_CFG_LOCK_PROFILE_BINS           8
+
+/**
+ * @brief   NilStatsFIFO record latency.
+ * @details If TRUE, @p NilStatsFIFO time stamps records and prints a
+ *          histogram of the time records wait in the FIFO.  Each record
+ *          uses three more bytes of RAM and each FIFO about 72 more bytes.
+ *          Waits longer than about 262 msec on a 16 MHz Arduino are
+ *          counted in the top bin.
+ */
+#define NIL_CFG_FIFO_LATENCY                FALSE
+
+/**
+ * @brief   Stack overflow check.
+ * @details If TRUE, a guard word at the bottom of each working area is
+ *          checked when a thread is switched out.  An overflow halts
+ *          the system with the thread name as the debug message.
+ */
+#define NIL_CFG_STACK_CHECK                 FALSE
+
+/**
+ * @brief   Stack high-water mark monitor.
+ * @details If TRUE, the idle enter hook scans a few bytes of a thread
+ *          stack each time the idle thread is entered.  Unused stack
+ *          bytes are then available in constant time with
+ *          @p nilStackMonitorUnused().
+ * @note    Stacks must be filled by @p nilSysBegin().
+ */
+#define NIL_CFG_STACK_MONITOR               FALSE
+
+/**
+ * @brief   Stack bytes checked by each step of the stack monitor.
+ */
+#define NIL_CFG_STACK_MONITOR_CHUNK         8
+
 /**
  * @brief   System assertions.
  */
@@ -88,6 +197,7 @@
  * @note    This macro can be used to activate a power saving mode.
  */
 #define NIL_CFG_IDLE_ENTER_HOOK() {                                         \
+  NIL_STACK_MONITOR_STEP();                                                 \
 }
 
 /**
@@ -52,6 +52,40 @@
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if NIL_CFG_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Timer 1 prescale factor for the tick-less mode.
+ * @details Timer 1 is a free-running counter that is incremented at
+ *          @p NIL_CFG_FREQUENCY so the system time is the timer count.
+ */
+#define PORT_TIMER_PRESCALE             (F_CPU / NIL_CFG_FREQUENCY)
+
+#if PORT_TIMER_PRESCALE == 1
+#define PORT_TIMER_CS                   (1 << CS10)
+#elif PORT_TIMER_PRESCALE == 8
+#define PORT_TIMER_CS                   (1 << CS11)
+#elif PORT_TIMER_PRESCALE == 64
+#define PORT_TIMER_CS                   ((1 << CS11) | (1 << CS10))
+#elif PORT_TIMER_PRESCALE == 256
+#define PORT_TIMER_CS                   (1 << CS12)
+#elif PORT_TIMER_PRESCALE == 1024
+#define PORT_TIMER_CS                   ((1 << CS12) | (1 << CS10))
+#else
+#error "tick-less NIL_CFG_FREQUENCY must be F_CPU/(1, 8, 64, 256, or 1024)"
+#endif
+#endif /* NIL_CFG_TIMEDELTA > 0 */
+
+/**
+ * @brief   CPU cycles per count of @p port_time_stamp() and
+ *          @p port_time_hires().
+ * @details Timer 0 is prescaled by 64 in the Arduino core.
+ */
+#if NIL_CFG_TIMEDELTA == 0 || defined(__DOXYGEN__)
+#define PORT_TIME_STAMP_CYCLES          64
+#else
+#define PORT_TIME_STAMP_CYCLES          PORT_TIMER_PRESCALE
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -168,7 +202,8 @@ struct port_intctx {
  */
 #define THD_WA_SIZE(n) STACK_ALIGN((sizeof(struct port_intctx) - 1) +       \
                                    (sizeof(struct port_extctx) - 1) +       \
-                                   (n) + (PORT_INT_REQUIRED_STACK))
+                                   (n) + (PORT_INT_REQUIRED_STACK) +        \
+                                   NIL_STACK_GUARD_SIZE)
 
 /**
  * @brief   Static working area allocation.
@@ -275,6 +310,36 @@ struct port_intctx {
  */
 #define port_wait_for_interrupt() asm volatile ("sleep" : : : "memory")
 
+#if NIL_CFG_TIMEDELTA > 0 || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the system time in tick-less mode.
+ * @details The system time is the timer 1 count.
+ */
+#define port_timer_get_time() TCNT1
+
+/**
+ * @brief   Starts the alarm.
+ * @details The alarm is a timer 1 compare A match at the specified time.
+ *
+ * @param[in] time      the time of the alarm
+ */
+#define port_timer_set_alarm(time) {                                        \
+  OCR1A = (time);                                                           \
+  TIFR1 = (1 << OCF1A);                                                     \
+  TIMSK1 |= (1 << OCIE1A);                                                  \
+}
+
+/**
+ * @brief   Stops the alarm.
+ */
+#define port_timer_reset_alarm() {TIMSK1 &= ~(1 << OCIE1A);}
+
+/**
+ * @brief   Returns the time of the alarm.
+ */
+#define port_timer_get_alarm() OCR1A
+#endif /* NIL_CFG_TIMEDELTA > 0 */
+
 /**
  * @brief   Performs a context switch between two threads.
  * @details This is the most critical code in any port, this function
@@ -297,6 +362,8 @@ extern "C" {
   void _port_switch(thread_t *ntp, thread_t *otp);
   void _port_thread_start(void);
   void port_halt(void);
+  uint16_t port_time_stamp(void);
+  uint32_t port_time_hires(void);
 #ifdef __cplusplus
 }
 #endif
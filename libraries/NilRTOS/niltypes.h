@@ -40,6 +40,8 @@ typedef uint8_t         tstate_t;   /**< @brief Type of a thread state.     */
 typedef int16_t         msg_t;      /**< @brief Type of a message.          */
 typedef uint16_t        systime_t;  /**< @brief Type of system time.        */
 typedef int16_t         cnt_t;      /**< @brief Type of signed counter.     */
+typedef uint16_t        thdmask_t;  /**< @brief Type of a thread bit mask.  */
+typedef uint8_t         eventmask_t;/**< @brief Type of an event mask.      */
 /** @} */
 
 #endif /* _NILTYPES_H_ */
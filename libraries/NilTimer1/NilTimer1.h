@@ -28,6 +28,9 @@
 #ifndef NilTimer1_h
 #define NilTimer1_h
 #include <NilRTOS.h>
+#if NIL_CFG_TIMEDELTA
+#error NilTimer1 can't be used in tick-less mode
+#endif  // NIL_CFG_TIMEDELTA
 //------------------------------------------------------------------------------
 /** NilRTimer1 version YYYYMMDD */
 #define NIL_TIMER1_VERSION 20130719